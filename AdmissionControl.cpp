@@ -0,0 +1,236 @@
+#include "AdmissionControl.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace CppSerialPort {
+
+const size_t AdmissionControl::SOURCE_SHARD_COUNT{64};
+const size_t AdmissionControl::SOURCE_SWEEP_THRESHOLD{1024};
+
+TokenBucket::TokenBucket() :
+    TokenBucket{0, 0}
+{
+
+}
+
+TokenBucket::TokenBucket(double rate, double burst) :
+    m_rate{rate},
+    m_burst{burst},
+    m_tokens{burst},
+    m_lastRefill{Clock::now()}
+{
+
+}
+
+bool TokenBucket::isLimited() const
+{
+    return (this->m_rate > 0);
+}
+
+void TokenBucket::refill(Clock::time_point now)
+{
+    if (now <= this->m_lastRefill) {
+        return;
+    }
+    auto elapsed = std::chrono::duration<double>(now - this->m_lastRefill).count();
+    this->m_tokens = std::min(this->m_burst, this->m_tokens + (elapsed * this->m_rate));
+    this->m_lastRefill = now;
+}
+
+bool TokenBucket::hasRoom(double tokens, Clock::time_point now)
+{
+    if (!this->isLimited()) {
+        return true;
+    }
+    this->refill(now);
+    return ( (this->m_tokens >= tokens) || (this->m_tokens >= this->m_burst) );
+}
+
+void TokenBucket::take(double tokens)
+{
+    if (this->isLimited()) {
+        this->m_tokens -= tokens;
+    }
+}
+
+bool TokenBucket::isFull(Clock::time_point now) const
+{
+    if (!this->isLimited()) {
+        return true;
+    }
+    auto elapsed = std::chrono::duration<double>(now - this->m_lastRefill).count();
+    return ( (this->m_tokens + (std::max(elapsed, 0.0) * this->m_rate)) >= this->m_burst );
+}
+
+AdmissionControl::AdmissionControl() :
+    m_maximumConnections{0},
+    m_connectionsPerSecond{0},
+    m_connectionsPerSourcePerSecond{0},
+    m_messagesPerSecond{0},
+    m_messagesPerSourcePerSecond{0},
+    m_bytesPerSecond{0},
+    m_bytesPerSourcePerSecond{0},
+    m_sourceShards{new SourceShard[SOURCE_SHARD_COUNT]},
+    m_rejectedConnections{0},
+    m_rejectedMessages{0}
+{
+    for (size_t i = 0; i < SOURCE_SHARD_COUNT; i++) {
+        this->m_sourceShards[i].sweepThreshold = SOURCE_SWEEP_THRESHOLD;
+    }
+}
+
+void AdmissionControl::setMaximumConnections(size_t maximumConnections)
+{
+    this->m_maximumConnections = maximumConnections;
+}
+
+void AdmissionControl::setConnectionRate(double perSecond, double perSourcePerSecond)
+{
+    this->m_connectionsPerSecond = perSecond;
+    this->m_connectionsPerSourcePerSecond = perSourcePerSecond;
+}
+
+void AdmissionControl::setMessageRate(double perSecond, double perSourcePerSecond)
+{
+    this->m_messagesPerSecond = perSecond;
+    this->m_messagesPerSourcePerSecond = perSourcePerSecond;
+}
+
+void AdmissionControl::setByteRate(double perSecond, double perSourcePerSecond)
+{
+    this->m_bytesPerSecond = perSecond;
+    this->m_bytesPerSourcePerSecond = perSourcePerSecond;
+}
+
+size_t AdmissionControl::maximumConnections() const
+{
+    return this->m_maximumConnections;
+}
+
+bool AdmissionControl::isEnabled() const
+{
+    return ( (this->m_maximumConnections > 0) || (this->m_connectionsPerSecond > 0) || (this->m_connectionsPerSourcePerSecond > 0) || (this->limitsMessages()) );
+}
+
+bool AdmissionControl::limitsMessages() const
+{
+    return ( (this->m_messagesPerSecond > 0) || (this->m_messagesPerSourcePerSecond > 0) || (this->m_bytesPerSecond > 0) || (this->m_bytesPerSourcePerSecond > 0) );
+}
+
+bool AdmissionControl::limitsSources() const
+{
+    return ( (this->m_connectionsPerSourcePerSecond > 0) || (this->m_messagesPerSourcePerSecond > 0) || (this->m_bytesPerSourcePerSecond > 0) );
+}
+
+AdmissionControl::Share AdmissionControl::createShare(size_t shareCount) const
+{
+    //Every bucket allows a burst of one second's worth of its rate
+    auto count = static_cast<double>(std::max<size_t>(shareCount, 1));
+    Share returnValue{};
+    returnValue.m_connections = TokenBucket{this->m_connectionsPerSecond / count, std::max(this->m_connectionsPerSecond / count, 1.0)};
+    returnValue.m_messages = TokenBucket{this->m_messagesPerSecond / count, std::max(this->m_messagesPerSecond / count, 1.0)};
+    returnValue.m_bytes = TokenBucket{this->m_bytesPerSecond / count, std::max(this->m_bytesPerSecond / count, 1.0)};
+    return returnValue;
+}
+
+bool AdmissionControl::admitConnection(Share &share, const PeerAddress &peer, size_t openConnections, std::shared_ptr<Source> &source)
+{
+    source.reset();
+    //The cap is checked against the shared connection count, so reactors accepting at the same moment may overshoot it by one each
+    if ( (this->m_maximumConnections > 0) && (openConnections >= this->m_maximumConnections) ) {
+        this->m_rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    auto now = TokenBucket::Clock::now();
+    if (!share.m_connections.hasRoom(1, now)) {
+        this->m_rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (this->limitsSources()) {
+        source = this->findSource(peer.host(), now);
+        std::lock_guard<std::mutex> sourceLock{source->m_mutex};
+        (void)sourceLock;
+        if (!source->m_connections.hasRoom(1, now)) {
+            source.reset();
+            this->m_rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        source->m_connections.take(1);
+    }
+    share.m_connections.take(1);
+    return true;
+}
+
+bool AdmissionControl::admitMessage(Share &share, Source *source, size_t length, TokenBucket::Clock::time_point now)
+{
+    auto bytes = static_cast<double>(length);
+    if ( (!share.m_messages.hasRoom(1, now)) || (!share.m_bytes.hasRoom(bytes, now)) ) {
+        this->m_rejectedMessages.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (source != nullptr) {
+        std::lock_guard<std::mutex> sourceLock{source->m_mutex};
+        (void)sourceLock;
+        if ( (!source->m_messages.hasRoom(1, now)) || (!source->m_bytes.hasRoom(bytes, now)) ) {
+            this->m_rejectedMessages.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        source->m_messages.take(1);
+        source->m_bytes.take(bytes);
+    }
+    share.m_messages.take(1);
+    share.m_bytes.take(bytes);
+    return true;
+}
+
+std::shared_ptr<AdmissionControl::Source> AdmissionControl::findSource(const std::string &host, TokenBucket::Clock::time_point now)
+{
+    auto &shard = this->m_sourceShards[std::hash<std::string>{}(host) % SOURCE_SHARD_COUNT];
+    std::lock_guard<std::mutex> shardLock{shard.mutex};
+    (void)shardLock;
+    auto found = shard.sources.find(host);
+    if (found != shard.sources.end()) {
+        return found->second;
+    }
+    //A source nobody is connected from, whose buckets have refilled, carries no state worth keeping
+    if (shard.sources.size() >= shard.sweepThreshold) {
+        for (auto it = shard.sources.begin(); it != shard.sources.end(); ) {
+            auto &candidate = *it->second;
+            std::unique_lock<std::mutex> sourceLock{candidate.m_mutex};
+            auto idle = ( (it->second.use_count() == 1) && (candidate.m_connections.isFull(now)) && (candidate.m_messages.isFull(now)) && (candidate.m_bytes.isFull(now)) );
+            sourceLock.unlock();
+            it = (idle ? shard.sources.erase(it) : std::next(it));
+        }
+        //Sweep again only once the shard has doubled past what is still live
+        shard.sweepThreshold = std::max(SOURCE_SWEEP_THRESHOLD, shard.sources.size() * 2);
+    }
+    std::shared_ptr<Source> source{new Source{}};
+    source->m_connections = TokenBucket{this->m_connectionsPerSourcePerSecond, std::max(this->m_connectionsPerSourcePerSecond, 1.0)};
+    source->m_messages = TokenBucket{this->m_messagesPerSourcePerSecond, std::max(this->m_messagesPerSourcePerSecond, 1.0)};
+    source->m_bytes = TokenBucket{this->m_bytesPerSourcePerSecond, std::max(this->m_bytesPerSourcePerSecond, 1.0)};
+    shard.sources.emplace(host, source);
+    return source;
+}
+
+void AdmissionControl::clear()
+{
+    for (size_t i = 0; i < SOURCE_SHARD_COUNT; i++) {
+        std::lock_guard<std::mutex> shardLock{this->m_sourceShards[i].mutex};
+        (void)shardLock;
+        this->m_sourceShards[i].sources.clear();
+        this->m_sourceShards[i].sweepThreshold = SOURCE_SWEEP_THRESHOLD;
+    }
+}
+
+uint64_t AdmissionControl::rejectedConnections() const
+{
+    return this->m_rejectedConnections.load(std::memory_order_relaxed);
+}
+
+uint64_t AdmissionControl::rejectedMessages() const
+{
+    return this->m_rejectedMessages.load(std::memory_order_relaxed);
+}
+
+} //namespace CppSerialPort
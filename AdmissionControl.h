@@ -0,0 +1,140 @@
+#ifndef CPPSERIALPORT_ADMISSIONCONTROL_H
+#define CPPSERIALPORT_ADMISSIONCONTROL_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#include "PeerAddress.h"
+
+namespace CppSerialPort {
+
+/*
+ * Token bucket refilled continuously at rate tokens per second, holding at
+ * most burst tokens. A zero rate never limits. Not thread-safe
+ */
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket();
+    TokenBucket(double rate, double burst);
+
+    bool isLimited() const;
+    //Refills, then checks without taking, so several buckets can be checked before any is charged.
+    //A full bucket always has room, so a request larger than the burst still gets through once
+    bool hasRoom(double tokens, Clock::time_point now);
+    //May leave the bucket in debt, which the refill pays off before anything else gets through
+    void take(double tokens);
+    //Refilled to the brim, so forgetting the bucket loses nothing
+    bool isFull(Clock::time_point now) const;
+
+private:
+    double m_rate;
+    double m_burst;
+    double m_tokens;
+    Clock::time_point m_lastRefill;
+
+    void refill(Clock::time_point now);
+};
+
+/*
+ * Overload protection for TcpServer: a cap on open connections plus token
+ * buckets for new connections, frames and frame bytes per second, both server
+ * wide and per source address. Server wide budgets are split evenly into one
+ * Share per reactor, so the data path never takes a lock shared between
+ * reactors. Per source buckets live in a sharded table and are shared by
+ * every connection from that address, idle entries are swept as new ones are
+ * added. Rejections are only counted, tracing each one would add to the overload
+ */
+class AdmissionControl
+{
+public:
+    //One reactor's part of the server wide budgets, only touched by that reactor's thread
+    class Share
+    {
+    public:
+        Share() = default;
+
+    private:
+        friend class AdmissionControl;
+        TokenBucket m_connections;
+        TokenBucket m_messages;
+        TokenBucket m_bytes;
+    };
+
+    //Buckets for one source address, shared by its connections on every reactor
+    class Source
+    {
+    public:
+        Source() = default;
+        Source(const Source &) = delete;
+        Source &operator=(const Source &) = delete;
+
+    private:
+        friend class AdmissionControl;
+        std::mutex m_mutex;
+        TokenBucket m_connections;
+        TokenBucket m_messages;
+        TokenBucket m_bytes;
+    };
+
+    AdmissionControl();
+    AdmissionControl(const AdmissionControl &) = delete;
+    AdmissionControl &operator=(const AdmissionControl &) = delete;
+
+    //0 leaves a limit off. Changes apply to shares and sources created afterwards
+    void setMaximumConnections(size_t maximumConnections);
+    void setConnectionRate(double perSecond, double perSourcePerSecond);
+    void setMessageRate(double perSecond, double perSourcePerSecond);
+    void setByteRate(double perSecond, double perSourcePerSecond);
+    size_t maximumConnections() const;
+    bool isEnabled() const;
+    bool limitsMessages() const;
+
+    Share createShare(size_t shareCount) const;
+    //Null source means the connection was rejected, or that no per source limit is set (check admitted)
+    bool admitConnection(Share &share, const PeerAddress &peer, size_t openConnections, std::shared_ptr<Source> &source);
+    bool admitMessage(Share &share, Source *source, size_t length, TokenBucket::Clock::time_point now);
+    //Forgets every source, for a server that runs again
+    void clear();
+
+    uint64_t rejectedConnections() const;
+    uint64_t rejectedMessages() const;
+
+private:
+    static const size_t SOURCE_SHARD_COUNT;
+    //A shard is only swept for idle sources once it holds this many
+    static const size_t SOURCE_SWEEP_THRESHOLD;
+
+    struct SourceShard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Source>> sources;
+        size_t sweepThreshold;
+    };
+
+    size_t m_maximumConnections;
+    double m_connectionsPerSecond;
+    double m_connectionsPerSourcePerSecond;
+    double m_messagesPerSecond;
+    double m_messagesPerSourcePerSecond;
+    double m_bytesPerSecond;
+    double m_bytesPerSourcePerSecond;
+    std::unique_ptr<SourceShard[]> m_sourceShards;
+    std::atomic<uint64_t> m_rejectedConnections;
+    std::atomic<uint64_t> m_rejectedMessages;
+
+    bool limitsSources() const;
+    std::shared_ptr<Source> findSource(const std::string &host, TokenBucket::Clock::time_point now);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_ADMISSIONCONTROL_H
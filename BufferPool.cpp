@@ -0,0 +1,231 @@
+#include "BufferPool.h"
+
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace CppSerialPort {
+
+const size_t BufferPool::MINIMUM_BUFFER_SIZE{256};
+const size_t BufferPool::MAXIMUM_BUFFER_SIZE{1024 * 1024};
+
+//256 bytes to 1 MB in powers of two
+static const size_t SIZE_CLASS_COUNT{13};
+//Free bytes kept per size class, in each thread and in the shared lists
+static const size_t THREAD_CACHE_BYTES{256 * 1024};
+static const size_t SHARED_CACHE_BYTES{4 * 1024 * 1024};
+
+static size_t sizeClassIndex(size_t minimumSize)
+{
+    size_t index{0};
+    for (auto capacity = BufferPool::MINIMUM_BUFFER_SIZE; capacity < minimumSize; capacity <<= 1) {
+        index++;
+    }
+    return index;
+}
+
+static size_t cacheLimit(size_t cacheBytes, size_t index)
+{
+    //Never fewer than two, so a buffer that is released and acquired again in turn stays cached
+    return std::max<size_t>(cacheBytes / (BufferPool::MINIMUM_BUFFER_SIZE << index), 2);
+}
+
+struct SharedSizeClass
+{
+    std::mutex mutex;
+    std::vector<char *> buffers;
+};
+
+static SharedSizeClass *sharedSizeClasses()
+{
+    //Never destroyed, so thread caches torn down after main() returns can still hand their buffers back
+    static auto sizeClasses = new SharedSizeClass[SIZE_CLASS_COUNT];
+    return sizeClasses;
+}
+
+static char *takeShared(size_t index)
+{
+    auto &shared = sharedSizeClasses()[index];
+    std::lock_guard<std::mutex> sharedLock{shared.mutex};
+    (void)sharedLock;
+    if (shared.buffers.empty()) {
+        return new char[BufferPool::MINIMUM_BUFFER_SIZE << index];
+    }
+    auto data = shared.buffers.back();
+    shared.buffers.pop_back();
+    return data;
+}
+
+static void returnShared(size_t index, char *data)
+{
+    auto &shared = sharedSizeClasses()[index];
+    std::lock_guard<std::mutex> sharedLock{shared.mutex};
+    (void)sharedLock;
+    if (shared.buffers.size() < cacheLimit(SHARED_CACHE_BYTES, index)) {
+        shared.buffers.push_back(data);
+    } else {
+        delete[] data;
+    }
+}
+
+//Trivially destructible, so it can still be read while thread_local and static objects are being torn down
+static thread_local bool threadCacheDestroyed{false};
+
+struct ThreadCache
+{
+    std::vector<char *> buffers[SIZE_CLASS_COUNT];
+
+    ~ThreadCache()
+    {
+        threadCacheDestroyed = true;
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+            for (auto it : this->buffers[i]) {
+                returnShared(i, it);
+            }
+        }
+    }
+};
+
+//Null once the calling thread's cache is gone, buffers released during exit go straight to the shared lists
+static ThreadCache *localThreadCache()
+{
+    if (threadCacheDestroyed) {
+        return nullptr;
+    }
+    static thread_local ThreadCache threadCache{};
+    return &threadCache;
+}
+
+PooledBuffer::PooledBuffer() :
+    m_data{nullptr},
+    m_capacity{0}
+{
+
+}
+
+PooledBuffer::PooledBuffer(char *data, size_t capacity) :
+    m_data{data},
+    m_capacity{capacity}
+{
+
+}
+
+PooledBuffer::~PooledBuffer()
+{
+    this->release();
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer &&other) noexcept :
+    m_data{other.m_data},
+    m_capacity{other.m_capacity}
+{
+    other.m_data = nullptr;
+    other.m_capacity = 0;
+}
+
+PooledBuffer &PooledBuffer::operator=(PooledBuffer &&other) noexcept
+{
+    if (this != &other) {
+        this->release();
+        this->m_data = other.m_data;
+        this->m_capacity = other.m_capacity;
+        other.m_data = nullptr;
+        other.m_capacity = 0;
+    }
+    return *this;
+}
+
+char *PooledBuffer::data() const
+{
+    return this->m_data;
+}
+
+size_t PooledBuffer::capacity() const
+{
+    return this->m_capacity;
+}
+
+PooledBuffer::operator bool() const
+{
+    return (this->m_data != nullptr);
+}
+
+void PooledBuffer::release()
+{
+    if (this->m_data != nullptr) {
+        BufferPool::release(this->m_data, this->m_capacity);
+        this->m_data = nullptr;
+        this->m_capacity = 0;
+    }
+}
+
+size_t BufferPool::sizeClassCapacity(size_t minimumSize)
+{
+    if (minimumSize > MAXIMUM_BUFFER_SIZE) {
+        return minimumSize;
+    }
+    return (MINIMUM_BUFFER_SIZE << sizeClassIndex(minimumSize));
+}
+
+PooledBuffer BufferPool::acquire(size_t minimumSize)
+{
+    auto capacity = sizeClassCapacity(minimumSize);
+    if (capacity > MAXIMUM_BUFFER_SIZE) {
+        return PooledBuffer{new char[capacity], capacity};
+    }
+    auto index = sizeClassIndex(minimumSize);
+    auto threadCache = localThreadCache();
+    if (threadCache == nullptr) {
+        return PooledBuffer{takeShared(index), capacity};
+    }
+    auto &cached = threadCache->buffers[index];
+    if (cached.empty()) {
+        //Refill half the thread cache at once, so the shared lock is not taken on every acquire
+        auto &shared = sharedSizeClasses()[index];
+        std::lock_guard<std::mutex> sharedLock{shared.mutex};
+        (void)sharedLock;
+        auto count = std::min(shared.buffers.size(), cacheLimit(THREAD_CACHE_BYTES, index) / 2);
+        cached.insert(cached.end(), shared.buffers.end() - static_cast<std::ptrdiff_t>(count), shared.buffers.end());
+        shared.buffers.resize(shared.buffers.size() - count);
+    }
+    if (cached.empty()) {
+        return PooledBuffer{new char[capacity], capacity};
+    }
+    auto data = cached.back();
+    cached.pop_back();
+    return PooledBuffer{data, capacity};
+}
+
+void BufferPool::release(char *data, size_t capacity)
+{
+    if (capacity > MAXIMUM_BUFFER_SIZE) {
+        delete[] data;
+        return;
+    }
+    auto index = sizeClassIndex(capacity);
+    auto threadCache = localThreadCache();
+    if (threadCache == nullptr) {
+        returnShared(index, data);
+        return;
+    }
+    auto &cached = threadCache->buffers[index];
+    auto limit = cacheLimit(THREAD_CACHE_BYTES, index);
+    if (cached.size() >= limit) {
+        //Buffers released on another thread than the one that acquired them pile up here, so spill half
+        auto &shared = sharedSizeClasses()[index];
+        std::lock_guard<std::mutex> sharedLock{shared.mutex};
+        (void)sharedLock;
+        auto sharedLimit = cacheLimit(SHARED_CACHE_BYTES, index);
+        for (auto count = limit / 2; count > 0; count--) {
+            if (shared.buffers.size() < sharedLimit) {
+                shared.buffers.push_back(cached.back());
+            } else {
+                delete[] cached.back();
+            }
+            cached.pop_back();
+        }
+    }
+    cached.push_back(data);
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,61 @@
+#ifndef CPPSERIALPORT_BUFFERPOOL_H
+#define CPPSERIALPORT_BUFFERPOOL_H
+
+#include <cstddef>
+
+namespace CppSerialPort {
+
+/*
+ * Byte buffer on loan from the BufferPool, handed back when it is released,
+ * reassigned or destroyed. The contents are never zeroed, and the storage
+ * never moves, so pointers into it survive moving the handle
+ */
+class PooledBuffer
+{
+public:
+    PooledBuffer();
+    ~PooledBuffer();
+    PooledBuffer(PooledBuffer &&other) noexcept;
+    PooledBuffer &operator=(PooledBuffer &&other) noexcept;
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    char *data() const;
+    size_t capacity() const;
+    explicit operator bool() const;
+    void release();
+
+private:
+    friend class BufferPool;
+    PooledBuffer(char *data, size_t capacity);
+
+    char *m_data;
+    size_t m_capacity;
+};
+
+/*
+ * Process wide pool of buffers in power of two size classes, from
+ * MINIMUM_BUFFER_SIZE to MAXIMUM_BUFFER_SIZE. Every thread keeps a few free
+ * buffers of each class, so most acquire/release pairs take no lock, and
+ * spills the rest to a shared free list. Both are bounded, so memory a burst
+ * needed goes back to the allocator rather than staying cached for good.
+ * Requests above the largest class are allocated and freed directly
+ */
+class BufferPool
+{
+public:
+    //The capacity is minimumSize rounded up to its size class
+    static PooledBuffer acquire(size_t minimumSize);
+    static size_t sizeClassCapacity(size_t minimumSize);
+
+    static const size_t MINIMUM_BUFFER_SIZE;
+    static const size_t MAXIMUM_BUFFER_SIZE;
+
+private:
+    friend class PooledBuffer;
+    static void release(char *data, size_t capacity);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_BUFFERPOOL_H
@@ -0,0 +1,207 @@
+#ifndef CPPSERIALPORT_CONNECTIONTABLE_H
+#define CPPSERIALPORT_CONNECTIONTABLE_H
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+//Identifies one use of a descriptor, so a stale handle never matches a reused descriptor
+struct ConnectionHandle
+{
+    int descriptor;
+    uint32_t generation;
+};
+
+/*
+ * Concurrent table of connections keyed by descriptor. Slots are grouped into
+ * fixed size shards that are allocated on first use, and every slot has its own
+ * spin lock, so insert, find and remove are O(1) from any thread and never
+ * contend on a table wide lock. Memory grows with the highest descriptor in use
+ */
+template <typename T>
+class ConnectionTable
+{
+public:
+    explicit ConnectionTable(size_t capacity) :
+        m_shardCount{(capacity + SHARD_SIZE - 1) / SHARD_SIZE},
+        m_shards{new std::atomic<Shard *>[m_shardCount]},
+        m_size{0}
+    {
+        for (size_t i = 0; i < this->m_shardCount; i++) {
+            this->m_shards[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ConnectionTable()
+    {
+        for (size_t i = 0; i < this->m_shardCount; i++) {
+            delete this->m_shards[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    ConnectionTable(const ConnectionTable &) = delete;
+    ConnectionTable &operator=(const ConnectionTable &) = delete;
+
+    ConnectionHandle insert(int descriptor, const std::shared_ptr<T> &value)
+    {
+        auto &slot = this->slotFor(descriptor, true);
+        SlotLock slotLock{slot};
+        (void)slotLock;
+        if (!slot.value) {
+            this->m_size.fetch_add(1, std::memory_order_relaxed);
+        }
+        slot.value = value;
+        slot.generation++;
+        return ConnectionHandle{descriptor, slot.generation};
+    }
+
+    std::shared_ptr<T> find(int descriptor) const
+    {
+        auto slot = this->existingSlotFor(descriptor);
+        if (slot == nullptr) {
+            return nullptr;
+        }
+        SlotLock slotLock{*slot};
+        (void)slotLock;
+        return slot->value;
+    }
+
+    std::shared_ptr<T> find(const ConnectionHandle &handle) const
+    {
+        auto slot = this->existingSlotFor(handle.descriptor);
+        if (slot == nullptr) {
+            return nullptr;
+        }
+        SlotLock slotLock{*slot};
+        (void)slotLock;
+        return (slot->generation == handle.generation) ? slot->value : nullptr;
+    }
+
+    std::shared_ptr<T> remove(int descriptor)
+    {
+        auto slot = this->existingSlotFor(descriptor);
+        if (slot == nullptr) {
+            return nullptr;
+        }
+        std::shared_ptr<T> removed{nullptr};
+        {
+            SlotLock slotLock{*slot};
+            (void)slotLock;
+            removed.swap(slot->value);
+        }
+        if (removed) {
+            this->m_size.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return removed;
+    }
+
+    size_t size() const
+    {
+        return this->m_size.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+        return this->m_shardCount * SHARD_SIZE;
+    }
+
+    //The function runs outside of the slot lock, so it may call back into the table
+    template <typename Function>
+    void forEach(Function &&function) const
+    {
+        for (size_t i = 0; i < this->m_shardCount; i++) {
+            auto shard = this->m_shards[i].load(std::memory_order_acquire);
+            if (shard == nullptr) {
+                continue;
+            }
+            for (auto &slot : shard->slots) {
+                std::shared_ptr<T> value{nullptr};
+                {
+                    SlotLock slotLock{slot};
+                    (void)slotLock;
+                    value = slot.value;
+                }
+                if (value) {
+                    function(*value);
+                }
+            }
+        }
+    }
+
+private:
+    static const size_t SHARD_SIZE{4096};
+
+    struct Slot
+    {
+        mutable std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        uint32_t generation{0};
+        std::shared_ptr<T> value{nullptr};
+    };
+
+    struct Shard
+    {
+        Slot slots[SHARD_SIZE];
+    };
+
+    class SlotLock
+    {
+    public:
+        explicit SlotLock(const Slot &slot) : m_slot{slot} {
+            while (this->m_slot.lock.test_and_set(std::memory_order_acquire)) { }
+        }
+        ~SlotLock() {
+            this->m_slot.lock.clear(std::memory_order_release);
+        }
+    private:
+        const Slot &m_slot;
+    };
+
+    size_t m_shardCount;
+    std::unique_ptr<std::atomic<Shard *>[]> m_shards;
+    std::atomic<size_t> m_size;
+
+    Slot &slotFor(int descriptor, bool create)
+    {
+        if ( (descriptor < 0) || (static_cast<size_t>(descriptor) >= this->capacity()) ) {
+            throw std::runtime_error("CppSerialPort::ConnectionTable::slotFor(int, bool): invariant failure (descriptor out of range, " + std::to_string(descriptor) + " >= " + std::to_string(this->capacity()) + ')');
+        }
+        auto &shardPointer = this->m_shards[static_cast<size_t>(descriptor) / SHARD_SIZE];
+        auto shard = shardPointer.load(std::memory_order_acquire);
+        if ( (shard == nullptr) && (create) ) {
+            //Another thread may allocate the same shard concurrently, the loser frees its copy
+            auto newShard = new Shard{};
+            if (shardPointer.compare_exchange_strong(shard, newShard, std::memory_order_acq_rel)) {
+                shard = newShard;
+            } else {
+                delete newShard;
+            }
+        }
+        return shard->slots[static_cast<size_t>(descriptor) % SHARD_SIZE];
+    }
+
+    const Slot *existingSlotFor(int descriptor) const
+    {
+        if ( (descriptor < 0) || (static_cast<size_t>(descriptor) >= this->capacity()) ) {
+            return nullptr;
+        }
+        auto shard = this->m_shards[static_cast<size_t>(descriptor) / SHARD_SIZE].load(std::memory_order_acquire);
+        return (shard == nullptr) ? nullptr : &shard->slots[static_cast<size_t>(descriptor) % SHARD_SIZE];
+    }
+
+    Slot *existingSlotFor(int descriptor)
+    {
+        return const_cast<Slot *>(static_cast<const ConnectionTable *>(this)->existingSlotFor(descriptor));
+    }
+};
+
+template <typename T>
+const size_t ConnectionTable<T>::SHARD_SIZE;
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_CONNECTIONTABLE_H
@@ -14,10 +14,12 @@
 #include <netdb.h>
 
 #include <unistd.h>
+#include <fcntl.h>
 
 #include "ApplicationUtilities.h"
 #include "GlobalDefinitions.h"
 #include "TcpClient.h"
+#include "UdpClient.h"
 #include "ProgramOption.h"
 
 #include <getopt.h>
@@ -35,8 +37,9 @@ bool looksLikeIP(const char *str);
 std::string stdinTask();
 
 std::string tcpReadTask();
+int downloadFile(CppSerialPort::TcpClient &tcpClient);
 
-#define PROGRAM_OPTION_COUNT 6
+#define PROGRAM_OPTION_COUNT 11
 
 static const ProgramOption verboseOption       {'e', "verbose", no_argument, "Enable verbose logging"};
 static const ProgramOption helpOption          {'h', "help", no_argument, "Display help text and exit"};
@@ -44,6 +47,11 @@ static const ProgramOption versionOption       {'v', "version", no_argument, "Di
 static const ProgramOption portOption          {'p', "port", required_argument, "Specify the port to bind to (ex. 5555)"};
 static const ProgramOption hostOption          {'h', "host", required_argument, "Specify the hostname to use (ex. example.com or 192.168.1.15"};
 static const ProgramOption udpOption           {'u', "udp", no_argument, "Use UDP protocol instead of default (TCP)"};
+static const ProgramOption getOption           {'g', "get", required_argument, "Request this file from a server run with --serve-files, write it to --output, then exit (ex. captures/run1.pcap)"};
+static const ProgramOption outputOption        {'o', "output", required_argument, "Specify the file a --get download is written to, received with splice() (ex. run1.pcap)"};
+static const ProgramOption socketProfileOption {'k', "socket-profile", required_argument, "Specify the TCP socket tuning, default, latency (TCP_NODELAY, TCP_QUICKACK, SO_BUSY_POLL, small buffers) or bulk (autocorking, large buffers, TCP_NOTSENT_LOWAT) (ex. latency)"};
+static const ProgramOption zeroCopyOption      {'z', "zero-copy", required_argument, "Specify the bytes from which writes are sent with MSG_ZEROCOPY, smaller ones are copied, 0 disables it (ex. 32768)"};
+static const ProgramOption receiveBufferOption {'b', "receive-buffer", required_argument, "Specify the bytes received ahead of the reader that are buffered between reads, rounded up to a power of two (ex. 65536)"};
 
 static std::array<const ProgramOption *, PROGRAM_OPTION_COUNT> programOptions{
         &verboseOption,
@@ -51,7 +59,12 @@ static std::array<const ProgramOption *, PROGRAM_OPTION_COUNT> programOptions{
         &versionOption,
         &portOption,
         &hostOption,
-        &udpOption
+        &udpOption,
+        &socketProfileOption,
+        &zeroCopyOption,
+        &receiveBufferOption,
+        &getOption,
+        &outputOption
 };
 
 static struct option longOptions[PROGRAM_OPTION_COUNT + 1] {
@@ -61,6 +74,11 @@ static struct option longOptions[PROGRAM_OPTION_COUNT + 1] {
         portOption.toPosixOption(),
         hostOption.toPosixOption(),
         udpOption.toPosixOption(),
+        socketProfileOption.toPosixOption(),
+        zeroCopyOption.toPosixOption(),
+        receiveBufferOption.toPosixOption(),
+        getOption.toPosixOption(),
+        outputOption.toPosixOption(),
         {nullptr, 0, nullptr, 0}
 };
 
@@ -71,6 +89,11 @@ static const int constexpr MINIMUM_PORT_NUMBER{1024};
 static int portNumber{-1};
 static std::string hostName{""};
 static bool useTcp{true};
+static std::string socketProfileName{"default"};
+static int zeroCopyThreshold{0};
+static int receiveBufferSize{0};
+static std::string getPath{""};
+static std::string outputPath{""};
 static const char LINE_ENDING{'\n'};
 static const int constexpr BUFFER_MAX{1024};
 
@@ -93,7 +116,7 @@ template <char Delimiter = ' '> std::vector<std::string> split(const std::string
 void printToStdout(const std::string &msg);
 void printAddressMessageToStdout(const std::string &msg);
 
-static std::shared_ptr<CppSerialPort::TcpClient> tcpClient{nullptr};
+static std::shared_ptr<CppSerialPort::IByteStream> byteStream{nullptr};
 
 int main(int argc, char *argv[])
 {
@@ -125,6 +148,21 @@ int main(int argc, char *argv[])
             case 'u':
                 useTcp = false;
                 break;
+            case 'k':
+                socketProfileName = optarg;
+                break;
+            case 'z':
+                zeroCopyThreshold = std::stoi(optarg);
+                break;
+            case 'b':
+                receiveBufferSize = std::stoi(optarg);
+                break;
+            case 'g':
+                getPath = optarg;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
             default:
                 LOG_WARN() << TStringFormat(R"(Unknown option "{0}", skipping)", longOptions[optionIndex].name);
         }
@@ -137,7 +175,7 @@ int main(int argc, char *argv[])
         LOG_FATAL("") << TStringFormat("Port number may not be less than {0} ({1} < 0)", MINIMUM_PORT_NUMBER, portNumber);
     }
     if (portNumber == -1) {
-        for (int i = 1; i < argc; i++) {
+        for (int i = optind; i < argc; i++) {
             if ( (strlen(argv[i]) > 0) && (argv[i][0] != '-') && !(looksLikeIP(argv[i]))) {
                 portNumber = std::stoi(argv[i]);
             }
@@ -148,7 +186,7 @@ int main(int argc, char *argv[])
     }
 
     if (hostName.empty()) {
-        for (int i = 1; i < argc; i++) {
+        for (int i = optind; i < argc; i++) {
             if ( (strlen(argv[i]) > 0) && (argv[i][0] != '-') && (looksLikeIP(argv[i]))) {
                 hostName = argv[i];
             }
@@ -159,10 +197,45 @@ int main(int argc, char *argv[])
     }
     LOG_INFO("") << TStringFormat("Using host name {0}", hostName);
     LOG_INFO("") << TStringFormat("Using port number {0}", portNumber);
+    if ( (socketProfileName != "default") && (socketProfileName != "latency") && (socketProfileName != "bulk") ) {
+        LOG_FATAL("") << TStringFormat(R"(Unknown socket profile "{0}" (expected default, latency or bulk))", socketProfileName);
+    }
+    if (zeroCopyThreshold < 0) {
+        LOG_FATAL("") << TStringFormat("Zero copy threshold may not be negative ({0} < 0)", zeroCopyThreshold);
+    }
+    if (receiveBufferSize < 0) {
+        LOG_FATAL("") << TStringFormat("Receive buffer size may not be negative ({0} < 0)", receiveBufferSize);
+    }
+    if ( (!getPath.empty()) && ( (outputPath.empty()) || (!useTcp) ) ) {
+        LOG_FATAL("") << "Downloading a file needs TCP and an output file (--output)";
+    }
+    std::shared_ptr<CppSerialPort::TcpClient> tcpClient{nullptr};
+    if (useTcp) {
+        LOG_INFO("") << TStringFormat("Using socket profile {0}", socketProfileName);
+        tcpClient = std::make_shared<CppSerialPort::TcpClient>(hostName, static_cast<uint16_t>(portNumber));
+        tcpClient->setSocketProfile(CppSerialPort::SocketTuning::parseProfile(socketProfileName));
+        if (zeroCopyThreshold > 0) {
+            LOG_INFO("") << TStringFormat("Using MSG_ZEROCOPY for writes of {0} bytes or more", zeroCopyThreshold);
+            tcpClient->setZeroCopyThreshold(static_cast<size_t>(zeroCopyThreshold));
+        }
+        if (receiveBufferSize > 0) {
+            tcpClient->setReceiveBufferSize(static_cast<size_t>(receiveBufferSize));
+        }
+        LOG_INFO("") << TStringFormat("Using a receive buffer of {0} bytes", tcpClient->receiveBufferSize());
+        byteStream = tcpClient;
+    } else {
+        LOG_INFO("") << "Using UDP, every line is sent as one datagram";
+        byteStream = std::make_shared<CppSerialPort::UdpClient>(hostName, static_cast<uint16_t>(portNumber));
+    }
+    byteStream->setLineEnding(LINE_ENDING);
+    byteStream->openPort();
+    if (tcpClient) {
+        LOG_INFO("") << TStringFormat("Effective socket options: {0}", tcpClient->effectiveSocketTuning().toString());
+    }
+    if (!getPath.empty()) {
+        exitApplication(downloadFile(*tcpClient));
+    }
     LOG_INFO("") << "Enter message to send";
-    tcpClient = std::make_shared<CppSerialPort::TcpClient>(hostName, static_cast<uint16_t>(portNumber));
-    tcpClient->setLineEnding(LINE_ENDING);
-    tcpClient->connect();
 
     using StringFuture = std::future<std::string>;
     StringFuture tcpFuture{std::async(std::launch::async, tcpReadTask)};
@@ -174,7 +247,7 @@ int main(int argc, char *argv[])
         }
         if (stdinFuture.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
             std::string toSend{stdinFuture.get()};
-            tcpClient->writeLine(toSend);
+            byteStream->writeLine(toSend);
             stdinFuture = std::async(std::launch::async, stdinTask);
         }
     }
@@ -199,6 +272,41 @@ void printToStdout(const std::string &msg)
     std::cout << msg << std::endl;
 }
 
+int downloadFile(CppSerialPort::TcpClient &tcpClient)
+{
+    //The server answers "OK <size>" or "ERROR <reason>", and the file bytes follow the OK line raw
+    tcpClient.writeLine("GET " + getPath);
+    bool timeout{false};
+    auto header = tcpClient.readLine(&timeout);
+    if ( (timeout) || (header.compare(0, 3, "OK ") != 0) ) {
+        LOG_INFO("") << TStringFormat("Download of {0} failed ({1})", getPath, (timeout ? std::string{"timed out"} : header));
+        return EXIT_FAILURE;
+    }
+    auto fileSize = static_cast<size_t>(std::stoull(header.substr(3)));
+    auto fileDescriptor = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fileDescriptor == -1) {
+        LOG_INFO("") << TStringFormat("open(const char *, int, mode_t): error code {0} ({1})", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    size_t received{0};
+    try {
+        received = tcpClient.receiveToDescriptor(fileDescriptor, fileSize);
+    } catch (std::exception &e) {
+        close(fileDescriptor);
+        LOG_INFO("") << TStringFormat("Download of {0} failed ({1})", getPath, e.what());
+        return EXIT_FAILURE;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    close(fileDescriptor);
+    if (received != fileSize) {
+        LOG_INFO("") << TStringFormat("Download of {0} stopped after {1} of {2} bytes", getPath, received, fileSize);
+        return EXIT_FAILURE;
+    }
+    LOG_INFO("") << TStringFormat("Downloaded {0} bytes to {1} in {2} s ({3} MB/s)", received, outputPath, elapsed, ((elapsed > 0) ? (received / elapsed / 1000000.0) : 0.0));
+    return EXIT_SUCCESS;
+}
+
 void exitApplication(int exitCode) 
 {
     exit(exitCode);
@@ -214,7 +322,7 @@ std::string tcpReadTask() {
     std::string returnString{""};
     bool timeout{false};
     while (true) {
-        returnString = tcpClient->readLine(&timeout);
+        returnString = byteStream->readLine(&timeout);
         if ( (!returnString.empty()) && (!timeout) ) {
             return returnString;
         }
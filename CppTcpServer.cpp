@@ -1,9 +1,11 @@
 #include <iostream>
 #include <vector>
-#include <future>
+#include <memory>
+#include <thread>
 #include <sstream>
 #include <csignal>
 #include <cstring>
+#include <cstdlib>
 #include <fstream>
 #include <forward_list>
 #include <cerrno>
@@ -13,12 +15,35 @@
 #include <netinet/in.h>
 #include <ifaddrs.h>
 #include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <climits>
+
+#if defined(__linux__) && defined(__has_include)
+#    if __has_include(<linux/openat2.h>)
+#        include <linux/openat2.h>
+#        if defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+#            define CPPSERIALPORT_HAS_OPENAT2 1
+#        endif
+#    endif
+#endif
 
 #include "ApplicationUtilities.h"
 #include "GlobalDefinitions.h"
 #include "ProgramOption.h"
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "TrafficLog.h"
+#include "PeerAddress.h"
+#include "FrameDecoder.h"
+#include "DatagramBatch.h"
+#include "CpuAffinity.h"
 
 #include <getopt.h>
 #include <arpa/inet.h>
@@ -31,13 +56,11 @@ using namespace ApplicationUtilities;
 
 static int verboseLogging{false};
 void globalLogHandler(LogLevel logLevel, LogContext logContext, const std::string &str);
-std::map<int, std::future<void>> connections;
-void closeConnection(int socketDescriptor);
 bool looksLikeIP(const char *str);
 bool startsWith(const std::string &str, const std::string &beginning);
 std::vector<std::pair<std::string, std::string>> getLocalIP();
 
-#define PROGRAM_OPTION_COUNT 6
+#define PROGRAM_OPTION_COUNT 27
 
 static const ProgramOption verboseOption       {'e', "verbose", no_argument, "Enable verbose logging"};
 static const ProgramOption helpOption          {'h', "help", no_argument, "Display help text and exit"};
@@ -45,6 +68,27 @@ static const ProgramOption versionOption       {'v', "version", no_argument, "Di
 static const ProgramOption portOption          {'p', "port", required_argument, "Specify the port to bind to (ex. 5555)"};
 static const ProgramOption hostOption          {'h', "host", required_argument, "Specify the hostname to use (ex. example.com or 192.168.1.15"};
 static const ProgramOption udpOption           {'u', "udp", no_argument, "Use UDP protocol instead of default (TCP)"};
+static const ProgramOption ioEngineOption      {'i', "io-engine", required_argument, "Specify the I/O engine, epoll or io_uring (ex. io_uring)"};
+static const ProgramOption framingOption       {'f', "framing", required_argument, "Specify the message framing, line or length (4 byte big endian prefix) (ex. length)"};
+static const ProgramOption batchOption         {'b', "batch", required_argument, "Specify the number of datagrams per recvmmsg/sendmmsg call in UDP mode (ex. 64)"};
+static const ProgramOption offloadOption       {'o', "udp-offload", no_argument, "Enable UDP_GRO/UDP_SEGMENT offload in UDP mode"};
+static const ProgramOption idleTimeoutOption   {'t', "idle-timeout", required_argument, "Specify the milliseconds without traffic before a connection is closed, 0 disables it (ex. 60000)"};
+static const ProgramOption readTimeoutOption   {'r', "read-timeout", required_argument, "Specify the milliseconds a peer has to finish a frame it started sending, 0 disables it (ex. 10000)"};
+static const ProgramOption writeTimeoutOption  {'s', "write-timeout", required_argument, "Specify the milliseconds queued responses may go unsent before a connection is closed, 0 disables it (ex. 30000)"};
+static const ProgramOption backlogOption       {'l', "backlog", required_argument, "Specify the listen backlog, capped by net.core.somaxconn (ex. 4096)"};
+static const ProgramOption deferAcceptOption   {'d', "defer-accept", required_argument, "Specify the seconds TCP_DEFER_ACCEPT waits for the first request bytes, 0 disables it (ex. 5)"};
+static const ProgramOption workersOption       {'w', "workers", required_argument, "Specify the number of reactor threads, each with its own SO_REUSEPORT listener (ex. 4)"};
+static const ProgramOption handlerThreadsOption{'j', "handler-threads", required_argument, "Specify the number of work-stealing threads that handle frames, 0 handles them on the reactor threads (ex. 4)"};
+static const ProgramOption serveFilesOption    {'g', "serve-files", required_argument, "Answer \"GET <path>\" frames with \"OK <size>\" and the file, sent with sendfile(), from under this directory (ex. /srv/captures)"};
+static const ProgramOption socketProfileOption {'k', "socket-profile", required_argument, "Specify the TCP socket tuning, default, latency (TCP_NODELAY, TCP_QUICKACK, SO_BUSY_POLL, small buffers) or bulk (autocorking, large buffers, TCP_NOTSENT_LOWAT) (ex. latency)"};
+static const ProgramOption maxConnectionsOption{'m', "max-connections", required_argument, "Specify the most connections open at once, further ones are answered BUSY and closed, 0 disables it (ex. 10000)"};
+static const ProgramOption connectionRateOption{'c', "connection-rate", required_argument, "Specify the new connections per second, overall and optionally per source address, 0 disables a limit (ex. 2000/50)"};
+static const ProgramOption messageRateOption   {'q', "message-rate", required_argument, "Specify the frames per second, overall and optionally per source address, frames over it are answered BUSY (ex. 100000/1000)"};
+static const ProgramOption byteRateOption      {'y', "byte-rate", required_argument, "Specify the frame bytes per second, overall and optionally per source address, frames over it are answered BUSY (ex. 100000000/1000000)"};
+static const ProgramOption zeroCopyOption      {'z', "zero-copy", required_argument, "Specify the bytes from which responses are sent with MSG_ZEROCOPY (epoll only), smaller ones are copied, 0 disables it (ex. 32768)"};
+static const ProgramOption cpuAffinityOption   {'a', "cpu-affinity", required_argument, "Pin worker i to the i-th CPU of this list, with its memory on that CPU's NUMA node, one worker per CPU unless --workers is given (ex. 0-3,8)"};
+static const ProgramOption numaNodeOption      {'x', "numa-node", required_argument, "Pin one worker to each physical core of this NUMA node, with its memory on that node (ex. 1)"};
+static const ProgramOption incomingCpuOption   {'I', "incoming-cpu", no_argument, "Steer connections and datagrams to the pinned worker whose CPU received them (SO_INCOMING_CPU, Linux 6.2+)"};
 
 static std::array<const ProgramOption *, PROGRAM_OPTION_COUNT> programOptions{
         &verboseOption,
@@ -52,7 +96,28 @@ static std::array<const ProgramOption *, PROGRAM_OPTION_COUNT> programOptions{
         &versionOption,
         &portOption,
         &hostOption,
-        &udpOption
+        &udpOption,
+        &workersOption,
+        &handlerThreadsOption,
+        &ioEngineOption,
+        &framingOption,
+        &batchOption,
+        &offloadOption,
+        &idleTimeoutOption,
+        &readTimeoutOption,
+        &writeTimeoutOption,
+        &backlogOption,
+        &deferAcceptOption,
+        &socketProfileOption,
+        &serveFilesOption,
+        &maxConnectionsOption,
+        &connectionRateOption,
+        &messageRateOption,
+        &byteRateOption,
+        &zeroCopyOption,
+        &cpuAffinityOption,
+        &numaNodeOption,
+        &incomingCpuOption
 };
 
 static struct option longOptions[PROGRAM_OPTION_COUNT + 1] {
@@ -62,21 +127,77 @@ static struct option longOptions[PROGRAM_OPTION_COUNT + 1] {
         portOption.toPosixOption(),
         hostOption.toPosixOption(),
         udpOption.toPosixOption(),
+        workersOption.toPosixOption(),
+        handlerThreadsOption.toPosixOption(),
+        ioEngineOption.toPosixOption(),
+        framingOption.toPosixOption(),
+        batchOption.toPosixOption(),
+        offloadOption.toPosixOption(),
+        idleTimeoutOption.toPosixOption(),
+        readTimeoutOption.toPosixOption(),
+        writeTimeoutOption.toPosixOption(),
+        backlogOption.toPosixOption(),
+        deferAcceptOption.toPosixOption(),
+        socketProfileOption.toPosixOption(),
+        serveFilesOption.toPosixOption(),
+        maxConnectionsOption.toPosixOption(),
+        connectionRateOption.toPosixOption(),
+        messageRateOption.toPosixOption(),
+        byteRateOption.toPosixOption(),
+        zeroCopyOption.toPosixOption(),
+        cpuAffinityOption.toPosixOption(),
+        numaNodeOption.toPosixOption(),
+        incomingCpuOption.toPosixOption(),
         {nullptr, 0, nullptr, 0}
 };
 
 
-static const int RECEIVE_TIMEOUT{1500};
-static const int MAX_INCOMING_CONNECTIONS{10};
+static int listenBacklog{SOMAXCONN};
+static int deferAccept{0};
 static const int constexpr MINIMUM_PORT_NUMBER{1024};
 static const int DEFAULT_PORT_NUMBER{5678};
 static int portNumber{-1};
 std::string hostName{""};
 static bool useTcp{true};
+//-1 until given, then one per pinned CPU or a single worker
+static int workerCount{-1};
+static std::string cpuAffinity{""};
+static int numaNode{-1};
+static bool incomingCpuSteering{false};
+static std::vector<int> workerCpus{};
+static int handlerThreadCount{0};
+static std::string ioEngine{"epoll"};
+static std::string framing{"line"};
+static CppSerialPort::FramingMode framingMode{CppSerialPort::FramingMode::LineDelimited};
+static std::string socketProfileName{"default"};
+static CppSerialPort::SocketTuning::Profile socketProfile{CppSerialPort::SocketTuning::Profile::Default};
+//Empty unless file serving is enabled
+static std::string fileRoot{""};
+//Every served file is opened relative to these, see openServedFile()
+static int fileRootDescriptor{-1};
+static std::string resolvedFileRoot{""};
+static const std::string GET_PREFIX{"GET "};
+//Overload limits as <overall>[/<per source>] per second, 0 disables a limit
+static int maximumConnections{0};
+static std::string connectionRate{"0"};
+static std::string messageRate{"0"};
+static std::string byteRate{"0"};
+static int zeroCopyThreshold{0};
+static const std::string OVERLOAD_RESPONSE{"BUSY"};
+static int datagramBatchSize{64};
+static bool udpOffload{false};
+//Connection deadlines in milliseconds, 0 disables one
+static int idleTimeout{60000};
+static int readTimeout{10000};
+static int writeTimeout{30000};
 static const char LINE_ENDING{'\n'};
-static const int constexpr BUFFER_MAX{1024};
+//Responses are gathered around the received payload, which is never copied into the response
+static const std::string RESPONSE_PREFIX{"Message received: \""};
+static const std::string RESPONSE_SUFFIX{std::string{"\""} + LINE_ENDING};
 
 static std::mutex coutMutex{};
+//Rx/Tx and connection tracing goes through the asynchronous log, so reactors never wait on stdout
+static CppSerialPort::TrafficLog trafficLog{STDOUT_FILENO};
 
 void exitApplication(int exitCode);
 void signalHandler(int signal);
@@ -94,12 +215,50 @@ template <char Delimiter = ' '> std::vector<std::string> split(const std::string
     return returnVector;
 }
 
-int *socketFileDescriptor{nullptr};
-struct timeval toTimeVal(uint32_t totalTimeout);
-std::string sockaddrToString(sockaddr *address, socklen_t addressLength);
+//The echo protocol: every frame is answered with RESPONSE_PREFIX + frame + RESPONSE_SUFFIX
+class EchoHandler : public CppSerialPort::ITcpServerHandler
+{
+public:
+    void onConnect(CppSerialPort::TcpConnection &connection) override;
+    void onFrame(CppSerialPort::TcpConnection &connection, const char *frame, size_t length) override;
+    void onClose(CppSerialPort::TcpConnection &connection) override;
+};
+
+//One bound socket, event loop and datagram batch pair per worker thread in UDP mode
+class DatagramReactor : public CppSerialPort::IEventHandler
+{
+public:
+    void handleEvents(int descriptor, uint32_t events) override;
+
+    int listenDescriptor{-1};
+    //Written by the signal handler and never read, so the loop stops even if it only starts running afterwards
+    int stopDescriptor{-1};
+    CppSerialPort::EventLoop eventLoop{};
+    std::unique_ptr<CppSerialPort::DatagramReceiveBatch> receiveBatch{};
+    std::unique_ptr<CppSerialPort::DatagramSendBatch> sendBatch{};
+};
+
+static EchoHandler echoHandler{};
+static std::unique_ptr<CppSerialPort::TcpServer> tcpServer{};
+static std::vector<std::unique_ptr<DatagramReactor>> datagramReactors{};
+//Set by the signal handler once it has asked the server to stop
+static volatile sig_atomic_t stopSignal{0};
+//Set while every datagram reactor exists and may be stopped from the signal handler
+static volatile sig_atomic_t datagramReactorsRunning{0};
+
 void printToStdout(const std::string &msg);
-void printAddressMessageToStdout(const std::string &msg, sockaddr *address);
-void handleConnection(int socketDescriptor, sockaddr acceptedAddress);
+void printAddressMessageToStdout(const std::string &msg, const CppSerialPort::PeerAddress &peer);
+void sendFrame(CppSerialPort::TcpConnection &connection, const std::string &frame);
+std::string encodeFrame(const std::string &frame);
+bool parseRateLimit(const std::string &rate, double *perSecond, double *perSourcePerSecond);
+void serveFile(CppSerialPort::TcpConnection &connection, const std::string &path);
+int openServedFile(const std::string &path);
+void runTcpServer();
+void runUdpServer();
+int createDatagramSocket(const addrinfo *listenAddress, bool reusePort);
+void handleDatagrams(DatagramReactor &reactor);
+bool setNonBlocking(int socketDescriptor);
+void raiseFileDescriptorLimit();
 
 static addrinfo *addressInfo{nullptr};
 
@@ -118,6 +277,9 @@ int main(int argc, char *argv[])
             break;
         }
         switch (currentOption) {
+            case 'e':
+                verboseLogging = true;
+                break;
             case 'h':
                 displayHelp();
                 exit(EXIT_SUCCESS);
@@ -133,6 +295,69 @@ int main(int argc, char *argv[])
             case 'u':
                 useTcp = false;
                 break;
+            case 'w':
+                workerCount = std::stoi(optarg);
+                break;
+            case 'j':
+                handlerThreadCount = std::stoi(optarg);
+                break;
+            case 'i':
+                ioEngine = optarg;
+                break;
+            case 'f':
+                framing = optarg;
+                break;
+            case 'b':
+                datagramBatchSize = std::stoi(optarg);
+                break;
+            case 'o':
+                udpOffload = true;
+                break;
+            case 't':
+                idleTimeout = std::stoi(optarg);
+                break;
+            case 'r':
+                readTimeout = std::stoi(optarg);
+                break;
+            case 's':
+                writeTimeout = std::stoi(optarg);
+                break;
+            case 'l':
+                listenBacklog = std::stoi(optarg);
+                break;
+            case 'd':
+                deferAccept = std::stoi(optarg);
+                break;
+            case 'k':
+                socketProfileName = optarg;
+                break;
+            case 'g':
+                fileRoot = optarg;
+                break;
+            case 'm':
+                maximumConnections = std::stoi(optarg);
+                break;
+            case 'c':
+                connectionRate = optarg;
+                break;
+            case 'q':
+                messageRate = optarg;
+                break;
+            case 'y':
+                byteRate = optarg;
+                break;
+            case 'z':
+                zeroCopyThreshold = std::stoi(optarg);
+                break;
+            case 'a':
+                cpuAffinity = optarg;
+                break;
+            case 'x':
+                numaNode = std::stoi(optarg);
+                break;
+            case 'I':
+                incomingCpuSteering = true;
+                break;
             default:
                 LOG_WARN() << TStringFormat(R"(Unknown option "{0}", skipping)", longOptions[optionIndex].name);
         }
@@ -145,7 +370,7 @@ int main(int argc, char *argv[])
         LOG_FATAL("") << TStringFormat("Port number may not be less than {0} ({1} < 0)", MINIMUM_PORT_NUMBER, portNumber);
     }
     if (portNumber == -1) {
-        for (int i = 1; i < argc; i++) {
+        for (int i = optind; i < argc; i++) {
             if ( (strlen(argv[i]) > 0) && (argv[i][0] != '-') && !(looksLikeIP(argv[i]))) {
                 portNumber = std::stoi(argv[i]);
             }
@@ -156,7 +381,7 @@ int main(int argc, char *argv[])
     }
 
     if (hostName.empty()) {
-        for (int i = 1; i < argc; i++) {
+        for (int i = optind; i < argc; i++) {
             if ( (strlen(argv[i]) > 0) && (argv[i][0] != '-') && (looksLikeIP(argv[i]))) {
                 hostName = argv[i];
             }
@@ -170,12 +395,174 @@ int main(int argc, char *argv[])
     }
     LOG_INFO() << TStringFormat("Using host name {0}", hostName);
     LOG_INFO() << TStringFormat("Using port number {0}", portNumber);
+    if ( (!cpuAffinity.empty()) && (numaNode != -1) ) {
+        LOG_FATAL("") << "Specify either a CPU list (--cpu-affinity) or a NUMA node (--numa-node), not both";
+    }
+    if (!cpuAffinity.empty()) {
+        try {
+            workerCpus = CppSerialPort::CpuAffinity::parseCpuList(cpuAffinity);
+        } catch (std::exception &e) {
+            LOG_FATAL("") << e.what();
+        }
+    } else if (numaNode != -1) {
+        workerCpus = CppSerialPort::CpuAffinity::numaNodeCores(numaNode);
+        if (workerCpus.empty()) {
+            LOG_FATAL("") << TStringFormat("NUMA node {0} has no CPUs (see /sys/devices/system/node)", numaNode);
+        }
+    }
+    if (workerCount == -1) {
+        workerCount = (workerCpus.empty() ? 1 : static_cast<int>(workerCpus.size()));
+    }
+    if (workerCount < 1) {
+        LOG_FATAL("") << TStringFormat("Worker count may not be less than 1 ({0} < 1)", workerCount);
+    }
+    LOG_INFO() << TStringFormat("Using {0} reactor thread(s)", workerCount);
+    if (!workerCpus.empty()) {
+        LOG_INFO() << TStringFormat("Pinning reactor threads to CPU(s) {0}{1}", CppSerialPort::CpuAffinity::toCpuList(workerCpus), (incomingCpuSteering ? ", steering by incoming CPU" : ""));
+    } else if (incomingCpuSteering) {
+        LOG_FATAL("") << "Steering by incoming CPU (--incoming-cpu) needs pinned workers (--cpu-affinity or --numa-node)";
+    }
+    if (handlerThreadCount < 0) {
+        LOG_FATAL("") << TStringFormat("Handler thread count may not be negative ({0} < 0)", handlerThreadCount);
+    }
+    if ( (useTcp) && (handlerThreadCount > 0) ) {
+        LOG_INFO() << TStringFormat("Using {0} handler thread(s)", handlerThreadCount);
+    }
+    if ( (ioEngine != "epoll") && (ioEngine != "io_uring") ) {
+        LOG_FATAL("") << TStringFormat(R"(Unknown I/O engine "{0}" (expected epoll or io_uring))", ioEngine);
+    }
+    LOG_INFO() << TStringFormat("Using I/O engine {0}", ioEngine);
+    if (framing == "line") {
+        framingMode = CppSerialPort::FramingMode::LineDelimited;
+    } else if (framing == "length") {
+        framingMode = CppSerialPort::FramingMode::LengthPrefixed;
+    } else {
+        LOG_FATAL("") << TStringFormat(R"(Unknown framing "{0}" (expected line or length))", framing);
+    }
+    LOG_INFO() << TStringFormat("Using {0} framing", framing);
+    if ( (idleTimeout < 0) || (readTimeout < 0) || (writeTimeout < 0) ) {
+        LOG_FATAL("") << TStringFormat("Timeouts may not be negative (idle {0}, read {1}, write {2})", idleTimeout, readTimeout, writeTimeout);
+    }
+    LOG_INFO() << TStringFormat("Using idle/read/write timeouts of {0}/{1}/{2} ms", idleTimeout, readTimeout, writeTimeout);
+    if ( (listenBacklog < 1) || (deferAccept < 0) ) {
+        LOG_FATAL("") << TStringFormat("Backlog must be positive and defer accept may not be negative (backlog {0}, defer accept {1})", listenBacklog, deferAccept);
+    }
+    if (useTcp) {
+        LOG_INFO() << TStringFormat("Using listen backlog {0}{1}", listenBacklog, ((deferAccept > 0) ? TStringFormat(", deferring accept up to {0} s", deferAccept) : ""));
+    }
+    if ( (socketProfileName != "default") && (socketProfileName != "latency") && (socketProfileName != "bulk") ) {
+        LOG_FATAL("") << TStringFormat(R"(Unknown socket profile "{0}" (expected default, latency or bulk))", socketProfileName);
+    }
+    socketProfile = CppSerialPort::SocketTuning::parseProfile(socketProfileName);
+    if (useTcp) {
+        //The effective values are traced once the first listener is bound
+        LOG_INFO() << TStringFormat("Using socket profile {0}", socketProfileName);
+    }
+    if ( (useTcp) && (!fileRoot.empty()) ) {
+        struct stat rootStatus{};
+        if ( (stat(fileRoot.c_str(), &rootStatus) == -1) || (!S_ISDIR(rootStatus.st_mode)) ) {
+            LOG_FATAL("") << TStringFormat("File root {0} is not a directory", fileRoot);
+        }
+        char resolvedPath[PATH_MAX];
+        fileRootDescriptor = open(fileRoot.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if ( (fileRootDescriptor == -1) || (realpath(fileRoot.c_str(), resolvedPath) == nullptr) ) {
+            LOG_FATAL("") << TStringFormat("Unable to open file root {0} ({1})", fileRoot, strerror(errno));
+        }
+        //Kept with a trailing '/', so /srv/files never matches /srv/files-private
+        resolvedFileRoot = resolvedPath;
+        if (resolvedFileRoot.back() != '/') {
+            resolvedFileRoot += '/';
+        }
+        LOG_INFO() << TStringFormat("Serving files from {0}", fileRoot);
+    }
+    if (maximumConnections < 0) {
+        LOG_FATAL("") << TStringFormat("Maximum connections may not be negative ({0} < 0)", maximumConnections);
+    }
+    for (const auto &it : {connectionRate, messageRate, byteRate}) {
+        if (!parseRateLimit(it, nullptr, nullptr)) {
+            LOG_FATAL("") << TStringFormat(R"(Invalid rate limit "{0}" (expected <overall>[/<per source>], ex. 1000/50))", it);
+        }
+    }
+    if ( (useTcp) && ( (maximumConnections > 0) || (connectionRate != "0") || (messageRate != "0") || (byteRate != "0") ) ) {
+        LOG_INFO() << TStringFormat("Using admission limits of {0} connections, {1} connections/s, {2} frames/s, {3} bytes/s", maximumConnections, connectionRate, messageRate, byteRate);
+    }
+    if (zeroCopyThreshold < 0) {
+        LOG_FATAL("") << TStringFormat("Zero copy threshold may not be negative ({0} < 0)", zeroCopyThreshold);
+    }
+    if ( (useTcp) && (zeroCopyThreshold > 0) ) {
+        if (ioEngine != "epoll") {
+            LOG_WARN() << "Only the epoll engine sends with MSG_ZEROCOPY, responses are copied";
+        }
+        LOG_INFO() << TStringFormat("Using MSG_ZEROCOPY for sends of {0} bytes or more", zeroCopyThreshold);
+    }
+    if (!useTcp) {
+        if ( (datagramBatchSize < 1) || (datagramBatchSize > UIO_MAXIOV) ) {
+            LOG_FATAL("") << TStringFormat("Datagram batch size must be between 1 and {0} ({1})", UIO_MAXIOV, datagramBatchSize);
+        }
+        //Every datagram is one message, and the batched syscalls have no io_uring counterpart here
+        if (ioEngine != "epoll") {
+            LOG_WARN() << "UDP mode always uses the epoll engine";
+            ioEngine = "epoll";
+        }
+        LOG_INFO() << TStringFormat("Using UDP with {0} datagram(s) per batch{1}", datagramBatchSize, (udpOffload ? ", with UDP_GRO/UDP_SEGMENT offload" : ""));
+    }
+    installSignalHandlers(signalHandler);
+    raiseFileDescriptorLimit();
+    std::cout.flush();
+    trafficLog.start();
+    if (useTcp) {
+        runTcpServer();
+    } else {
+        runUdpServer();
+    }
+    exitApplication((stopSignal != 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+void runTcpServer()
+{
+    tcpServer = std::make_unique<CppSerialPort::TcpServer>(hostName, static_cast<uint16_t>(portNumber), &echoHandler);
+    tcpServer->setWorkerCount(workerCount);
+    tcpServer->setWorkerCpus(workerCpus);
+    tcpServer->setIncomingCpuSteering(incomingCpuSteering);
+    tcpServer->setHandlerThreadCount(handlerThreadCount);
+    tcpServer->setIoEngine((ioEngine == "io_uring") ? CppSerialPort::TcpServer::IoEngine::IoUring : CppSerialPort::TcpServer::IoEngine::Epoll);
+    tcpServer->setFramingMode(framingMode);
+    tcpServer->setIdleTimeout(std::chrono::milliseconds{idleTimeout});
+    tcpServer->setReadTimeout(std::chrono::milliseconds{readTimeout});
+    tcpServer->setWriteTimeout(std::chrono::milliseconds{writeTimeout});
+    tcpServer->setListenBacklog(listenBacklog);
+    tcpServer->setDeferAccept(std::chrono::seconds{deferAccept});
+    tcpServer->setSocketProfile(socketProfile);
+    tcpServer->setZeroCopyThreshold(static_cast<size_t>(zeroCopyThreshold));
+    double perSecond{0};
+    double perSourcePerSecond{0};
+    tcpServer->setMaximumConnections(static_cast<size_t>(maximumConnections));
+    parseRateLimit(connectionRate, &perSecond, &perSourcePerSecond);
+    tcpServer->setConnectionRateLimit(perSecond, perSourcePerSecond);
+    parseRateLimit(messageRate, &perSecond, &perSourcePerSecond);
+    tcpServer->setMessageRateLimit(perSecond, perSourcePerSecond);
+    parseRateLimit(byteRate, &perSecond, &perSourcePerSecond);
+    tcpServer->setByteRateLimit(perSecond, perSourcePerSecond);
+    tcpServer->setOverloadResponse(encodeFrame(OVERLOAD_RESPONSE));
+    tcpServer->setTrafficLog(&trafficLog);
+    try {
+        tcpServer->run();
+    } catch (std::exception &e) {
+        std::cout << e.what() << std::endl;
+        exitApplication(EXIT_FAILURE);
+    }
+    if ( (tcpServer->rejectedConnectionCount() > 0) || (tcpServer->rejectedMessageCount() > 0) ) {
+        LOG_INFO() << TStringFormat("Rejected {0} connection(s) and {1} frame(s) while overloaded", tcpServer->rejectedConnectionCount(), tcpServer->rejectedMessageCount());
+    }
+}
+
+void runUdpServer()
+{
     addrinfo hints{};
     memset(reinterpret_cast<void *>(&hints), 0, sizeof(addrinfo));
     hints.ai_family = AF_UNSPEC; //IPV4 or IPV6
-    hints.ai_socktype = SOCK_STREAM; //TCP
+    hints.ai_socktype = SOCK_DGRAM; //UDP
     hints.ai_flags = 0; //Let me specify IP Address
-    installSignalHandlers(signalHandler);
     auto returnStatus = getaddrinfo(
             hostName.c_str(),
             toStdString(portNumber).c_str(), //Service (HTTP, port, etc)
@@ -218,62 +605,88 @@ int main(int argc, char *argv[])
         inet_ntop(addrInfoPtr->ai_family, addr, ipstr, sizeof(ipstr));
     } 
     */
-    auto socketDescriptor = socket(addressInfo->ai_family, addressInfo->ai_socktype, addressInfo->ai_protocol);
+    //Every reactor binds its own SO_REUSEPORT socket, so the kernel spreads
+    //incoming datagrams across them by flow
+    for (int i = 0; i < workerCount; i++) {
+        auto reactor = std::make_unique<DatagramReactor>();
+        reactor->listenDescriptor = createDatagramSocket(addressInfo, (workerCount > 1));
+        if ( (udpOffload) && (!CppSerialPort::DatagramReceiveBatch::enableReceiveOffload(reactor->listenDescriptor)) ) {
+            LOG_WARN() << TStringFormat("setsockopt(int, int, int, const void *, socklen_t) UDP_GRO: error code {0} ({1})", errno, strerror(errno));
+        }
+        if ( (incomingCpuSteering) && (!CppSerialPort::CpuAffinity::setIncomingCpu(reactor->listenDescriptor, workerCpus[i % workerCpus.size()])) ) {
+            LOG_WARN() << TStringFormat("setsockopt(int, int, int, const void *, socklen_t) SO_INCOMING_CPU: error code {0} ({1})", errno, strerror(errno));
+        }
+        reactor->receiveBatch = std::make_unique<CppSerialPort::DatagramReceiveBatch>(static_cast<size_t>(datagramBatchSize));
+        reactor->sendBatch = std::make_unique<CppSerialPort::DatagramSendBatch>(static_cast<size_t>(datagramBatchSize), udpOffload);
+        reactor->stopDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (reactor->stopDescriptor == -1) {
+            std::cout << "eventfd(unsigned int, int): error code " << errno << " (" << strerror(errno) << ")" << std::endl;
+            exitApplication(EXIT_FAILURE);
+        }
+        reactor->eventLoop.addDescriptor(reactor->listenDescriptor, EPOLLIN | EPOLLET, reactor.get());
+        reactor->eventLoop.addDescriptor(reactor->stopDescriptor, EPOLLIN, reactor.get());
+        datagramReactors.push_back(std::move(reactor));
+    }
+    datagramReactorsRunning = 1;
+    auto runReactor = [](size_t i) {
+        std::unique_ptr<CppSerialPort::CpuAffinity::ThreadBinding> binding{nullptr};
+        if (!workerCpus.empty()) {
+            binding = std::make_unique<CppSerialPort::CpuAffinity::ThreadBinding>(workerCpus[i % workerCpus.size()]);
+            for (const auto &it : binding->errors()) {
+                LOG_WARN() << it;
+            }
+        }
+        datagramReactors[i]->eventLoop.run();
+    };
+    std::vector<std::thread> workerThreads{};
+    for (size_t i = 1; i < datagramReactors.size(); i++) {
+        workerThreads.emplace_back(runReactor, i);
+    }
+    runReactor(0);
+    //The caller exits once every reactor thread is done, never while one is still in its event loop
+    for (auto &it : workerThreads) {
+        it.join();
+    }
+    datagramReactorsRunning = 0;
+}
+
+int createDatagramSocket(const addrinfo *listenAddress, bool reusePort)
+{
+    auto socketDescriptor = socket(listenAddress->ai_family, listenAddress->ai_socktype, listenAddress->ai_protocol);
     if (socketDescriptor == -1) {
         std::cout << "socket(int, int, int): error code " << errno << " (" << strerror(errno) << ")" << std::endl;
         exitApplication(EXIT_FAILURE);
-    } else {
-        socketFileDescriptor = &socketDescriptor;
     }
-    
-    //For a client, bind is only important is we want to choose the local port to bind to
-    //If a socket is not bound before connect(), the kernel will choose a random one
-    //However, for a server, bind MUST be called before calling listen()
-    auto bindResult = bind(socketDescriptor, addressInfo->ai_addr, addressInfo->ai_addrlen);
-    if (bindResult == -1) {
-        std::cout << "bind(int, sockaddr*, int) : error code " << errno << " (" << strerror(errno) << ")" << std::endl;
-        exitApplication(EXIT_FAILURE);
-    }
-    
+
+    //Address reuse only takes effect if it is set before bind()
     int acceptReuse{1};
     auto reuseSocketResult = setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &acceptReuse, sizeof(decltype(acceptReuse)));
     if (reuseSocketResult == -1) {
         std::cout << "setsockopt(int, int, int, const void *, socklen_t): error code " << errno << " (" << strerror(errno) << ")" << std::endl;
         exitApplication(EXIT_FAILURE);
     }
-    
-
-    /*
-    //server does not need to connect, but client would use:
-    auto connectResult = connect(socketDescriptor, addressInfo->ai_addr, addressInfo->ai_addrlen);
-    if (connectResult == -1) {
-        std::cout << "connect(int, const sockaddr *addr, socklen_t): error code " << errno << " (" << strerror(errno) << ")" << std::endl;
-        exitApplication(EXIT_FAILURE);    
+    if (reusePort) {
+        auto reusePortResult = setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEPORT, &acceptReuse, sizeof(decltype(acceptReuse)));
+        if (reusePortResult == -1) {
+            std::cout << "setsockopt(int, int, int, const void *, socklen_t) SO_REUSEPORT: error code " << errno << " (" << strerror(errno) << ")" << std::endl;
+            exitApplication(EXIT_FAILURE);
+        }
     }
-    */
 
-    auto listenResult = listen(socketDescriptor, MAX_INCOMING_CONNECTIONS);
-    if (listenResult == -1) {
-        std::cout << "listen(int, int): error code " << errno << " (" << strerror(errno) << ")" << std::endl;
+    //A datagram socket is ready to receive once bound
+    auto bindResult = bind(socketDescriptor, listenAddress->ai_addr, listenAddress->ai_addrlen);
+    if (bindResult == -1) {
+        std::cout << "bind(int, sockaddr*, int) : error code " << errno << " (" << strerror(errno) << ")" << std::endl;
         exitApplication(EXIT_FAILURE);
     }
 
-    sockaddr acceptedAddress{};
-    socklen_t acceptedAddressSize{0};
-    while (true) {
-        acceptedAddress = {};
-        acceptedAddressSize = sizeof(acceptedAddress);
-        auto acceptResult = accept(socketDescriptor, &acceptedAddress, &acceptedAddressSize);
-        if (acceptResult == -1) {
-            printToStdout(TStringFormat("accept(int, sockaddr *, size_t *): error code {0} ({1})", errno, strerror(errno)));
-            exitApplication(EXIT_FAILURE);
-        }
-        connections.emplace(socketDescriptor, std::async(std::launch::async, handleConnection, acceptResult, acceptedAddress));
-
+    if (!setNonBlocking(socketDescriptor)) {
+        std::cout << "fcntl(int, int, ...): error code " << errno << " (" << strerror(errno) << ")" << std::endl;
+        exitApplication(EXIT_FAILURE);
     }
+    return socketDescriptor;
 }
 
-
 bool looksLikeIP(const char *str)
 {
     static const std::regex ipv4Regex{"((25[0-5]|(2[0-4]|1{0,1}[0-9]){0,1}[0-9])\\.){3,3}(25[0-5]|(2[0-4]|1{0,1}[0-9]){0,1}[0-9])"};
@@ -281,112 +694,305 @@ bool looksLikeIP(const char *str)
     return (std::regex_match(str, ipv4Regex) || std::regex_match(str, ipv6Regex));
 }
 
-void handleConnection(int socketDescriptor, sockaddr addressStorage)
+void EchoHandler::onConnect(CppSerialPort::TcpConnection &connection)
 {
-    printAddressMessageToStdout("Incoming connection", &addressStorage);
-    //Set timeout
-    auto tv = toTimeVal(RECEIVE_TIMEOUT);
-    auto readTimeoutResult = setsockopt(socketDescriptor, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&tv), sizeof(struct timeval));
-    if (readTimeoutResult == -1) {
-        printToStdout(TStringFormat("setsockopt(int, int, int, const void *, int): error code {0} ({1})", errno, strerror(errno)));
-        exitApplication(EXIT_FAILURE);
+    (void)connection;
+}
+
+void EchoHandler::onFrame(CppSerialPort::TcpConnection &connection, const char *frame, size_t length)
+{
+    if (length == 0) {
+        return;
     }
-    
-    char buffer[BUFFER_MAX];
-    while (true) {
-        memset(buffer, '\0', BUFFER_MAX);
-        auto receiveResult = recv(socketDescriptor, buffer, BUFFER_MAX - 1, 0); //no flags
-        if (receiveResult == -1) {
-            if (errno != EAGAIN) {
-                printToStdout(TStringFormat("recv(int, void *, size_t, int): error code {0} ({1})", errno, strerror(errno)));
-                exitApplication(EXIT_FAILURE);
-            }
-        } else if (strlen(buffer) != 0) {
-            std::string receivedString{"Message received: \"" + stripLineEnding(buffer) + "\""};
-            printAddressMessageToStdout(TStringFormat("Rx << {0}", stripLineEnding(buffer)), &addressStorage);
-            receivedString += LINE_ENDING;
-            unsigned sentBytes{0};
-            //Make sure all bytes are sent
-            while (sentBytes < receivedString.length()) {
-                auto toSend = receivedString.substr(sentBytes);
-                auto sendResult = send(socketDescriptor, toSend.c_str(), toSend.length(), 0);
-                if (sendResult == -1) {
-                    printToStdout(TStringFormat("send(int, const void *, int, int): error code {0} ({1})", errno, strerror(errno)));
-                    exitApplication(EXIT_FAILURE);
-                }
-                sentBytes += sendResult;
-                printAddressMessageToStdout(TStringFormat("Tx >> {0}", stripLineEnding(receivedString)), &addressStorage);
+    std::string message{frame, length};
+    printAddressMessageToStdout("Rx << " + message, connection.peer());
+    if ( (!fileRoot.empty()) && (message.compare(0, GET_PREFIX.length(), GET_PREFIX) == 0) ) {
+        serveFile(connection, message.substr(GET_PREFIX.length()));
+        return;
+    }
+    printAddressMessageToStdout("Tx >> " + RESPONSE_PREFIX + message + '"', connection.peer());
+    //The frame stays valid until the server has flushed, so it is sent without a copy
+    if (framingMode == CppSerialPort::FramingMode::LengthPrefixed) {
+        char lengthPrefix[CppSerialPort::FrameDecoder::LENGTH_PREFIX_SIZE];
+        CppSerialPort::FrameDecoder::encodeLengthPrefix(static_cast<uint32_t>(RESPONSE_PREFIX.length() + length + 1), lengthPrefix);
+        connection.send(lengthPrefix, sizeof(lengthPrefix));
+        connection.sendStatic(RESPONSE_PREFIX.data(), RESPONSE_PREFIX.length());
+        connection.sendBorrowed(frame, length);
+        connection.sendStatic(RESPONSE_SUFFIX.data(), 1);
+    } else {
+        connection.sendStatic(RESPONSE_PREFIX.data(), RESPONSE_PREFIX.length());
+        connection.sendBorrowed(frame, length);
+        connection.sendStatic(RESPONSE_SUFFIX.data(), RESPONSE_SUFFIX.length());
+    }
+}
+
+void sendFrame(CppSerialPort::TcpConnection &connection, const std::string &frame)
+{
+    connection.send(encodeFrame(frame));
+}
+
+std::string encodeFrame(const std::string &frame)
+{
+    if (framingMode == CppSerialPort::FramingMode::LengthPrefixed) {
+        char lengthPrefix[CppSerialPort::FrameDecoder::LENGTH_PREFIX_SIZE];
+        CppSerialPort::FrameDecoder::encodeLengthPrefix(static_cast<uint32_t>(frame.length()), lengthPrefix);
+        return std::string{lengthPrefix, sizeof(lengthPrefix)} + frame;
+    }
+    return frame + LINE_ENDING;
+}
+
+bool parseRateLimit(const std::string &rate, double *perSecond, double *perSourcePerSecond)
+{
+    //<overall>[/<per source>], either part may be 0 to leave it unlimited
+    auto separator = rate.find('/');
+    double overall{0};
+    double perSource{0};
+    try {
+        size_t parsed{0};
+        overall = std::stod(rate.substr(0, separator), &parsed);
+        if (parsed != rate.substr(0, separator).length()) {
+            return false;
+        }
+        if (separator != std::string::npos) {
+            perSource = std::stod(rate.substr(separator + 1), &parsed);
+            if (parsed != rate.length() - separator - 1) {
+                return false;
             }
-        } else if (receiveResult == 0) {
-            printAddressMessageToStdout("Connection closed", &addressStorage);
-            closeConnection(socketDescriptor);
-            return;
         }
+    } catch (std::exception &) {
+        return false;
+    }
+    if ( (overall < 0) || (perSource < 0) ) {
+        return false;
+    }
+    if (perSecond != nullptr) {
+        *perSecond = overall;
+    }
+    if (perSourcePerSecond != nullptr) {
+        *perSourcePerSecond = perSource;
+    }
+    return true;
+}
+
+void serveFile(CppSerialPort::TcpConnection &connection, const std::string &path)
+{
+    //Only paths below the file root, so no absolute paths and no parent directory components
+    auto escapes = false;
+    std::istringstream components{path};
+    for (std::string component{}; std::getline(components, component, '/'); escapes |= (component == ".."));
+    if ( (path.empty()) || (path.front() == '/') || (escapes) ) {
+        printAddressMessageToStdout(TStringFormat("Tx >> ERROR invalid path {0}", path), connection.peer());
+        sendFrame(connection, "ERROR invalid path");
+        return;
+    }
+    auto fileDescriptor = openServedFile(path);
+    struct stat fileStatus{};
+    if ( (fileDescriptor == -1) || (fstat(fileDescriptor, &fileStatus) == -1) || (!S_ISREG(fileStatus.st_mode)) ) {
+        auto errorCode = ( (fileDescriptor == -1) ? errno : EISDIR );
+        if (fileDescriptor != -1) {
+            close(fileDescriptor);
+        }
+        printAddressMessageToStdout(TStringFormat("Tx >> ERROR {0} ({1})", path, strerror(errorCode)), connection.peer());
+        sendFrame(connection, TStringFormat("ERROR {0}", strerror(errorCode)));
+        return;
     }
+    //The header is framed, the file bytes follow it raw, the peer knows how many to expect
+    auto fileSize = static_cast<size_t>(fileStatus.st_size);
+    printAddressMessageToStdout(TStringFormat("Tx >> OK {0} ({1})", fileSize, path), connection.peer());
+    sendFrame(connection, TStringFormat("OK {0}", fileSize));
+    connection.sendFile(fileDescriptor, 0, fileSize);
 }
 
-void closeConnection(int socketDescriptor)
+//Opens path without leaving the file root or following a symbolic link. O_NONBLOCK, so a FIFO
+//cannot block the thread, anything but a regular file is turned down by the caller
+int openServedFile(const std::string &path)
 {
-    auto foundPosition = connections.find(socketDescriptor);
-    if (foundPosition != connections.end()) {
-        close(foundPosition->first);
-        connections.erase(foundPosition);
+    static const int OPEN_FLAGS{O_RDONLY | O_NONBLOCK | O_CLOEXEC};
+#if defined(CPPSERIALPORT_HAS_OPENAT2)
+    struct open_how openHow{};
+    openHow.flags = OPEN_FLAGS;
+    openHow.resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS;
+    auto fileDescriptor = static_cast<int>(syscall(SYS_openat2, fileRootDescriptor, path.c_str(), &openHow, sizeof(openHow)));
+    if ( (fileDescriptor != -1) || (errno != ENOSYS) ) {
+        return fileDescriptor;
+    }
+#endif
+    //Without openat2() the resolved path must still lie below the file root, and may no longer be a link itself
+    char resolvedPath[PATH_MAX];
+    if (realpath((fileRoot + '/' + path).c_str(), resolvedPath) == nullptr) {
+        return -1;
+    }
+    if (std::string{resolvedPath}.compare(0, resolvedFileRoot.length(), resolvedFileRoot) != 0) {
+        errno = EACCES;
+        return -1;
     }
+    return open(resolvedPath, OPEN_FLAGS | O_NOFOLLOW);
 }
 
-struct timeval toTimeVal(uint32_t totalTimeout)
+void EchoHandler::onClose(CppSerialPort::TcpConnection &connection)
 {
-    timeval tv{};
-    tv.tv_sec = totalTimeout / 1000;
-    tv.tv_usec = (totalTimeout % 1000) * 1000;
-    return tv;
+    (void)connection;
 }
 
+void DatagramReactor::handleEvents(int descriptor, uint32_t events)
+{
+    (void)events;
+    if (descriptor == this->stopDescriptor) {
+        this->eventLoop.stop();
+        return;
+    }
+    handleDatagrams(*this);
+}
 
-std::string sockaddrToString(sockaddr *address)
+void handleDatagrams(DatagramReactor &reactor)
 {
-    std::stringstream returnString{""};
-    char host[NI_MAXHOST];
-    char port[NI_MAXSERV];
-    memset(host, '\0', NI_MAXHOST);
-    memset(port, '\0', NI_MAXSERV);
-
-    getnameinfo(address, sizeof(*address), host, sizeof(host), port, sizeof(port), NI_NUMERICHOST);
-    returnString << '[' << host << ':' << port << ']';
-    return returnString.str();
+    auto &receiveBatch = *reactor.receiveBatch;
+    auto &sendBatch = *reactor.sendBatch;
+    //Edge-triggered, so the socket must be drained until recvmmsg() would block
+    while (true) {
+        auto receiveResult = receiveBatch.receive(reactor.listenDescriptor);
+        if (receiveResult == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            printToStdout(TStringFormat("recvmmsg(int, mmsghdr *, unsigned int, int, timespec *): error code {0} ({1})", errno, strerror(errno)));
+            break;
+        }
+        for (size_t i = 0; i < receiveBatch.size(); i++) {
+            if (receiveBatch.truncated(i)) {
+                continue;
+            }
+            //With UDP_GRO one entry may hold several datagrams from the same peer
+            auto segmentSize = receiveBatch.segmentSize(i);
+            for (size_t offset = 0; offset < receiveBatch.length(i); offset += segmentSize) {
+                auto payload = receiveBatch.data(i) + offset;
+                auto length = std::min(segmentSize, receiveBatch.length(i) - offset);
+                if ( (length > 0) && (payload[length - 1] == LINE_ENDING) ) {
+                    length--;
+                }
+                if (length == 0) {
+                    continue;
+                }
+                //Tracing every datagram would dominate at telemetry rates, so it is only done when verbose
+                if (verboseLogging) {
+                    CppSerialPort::PeerAddress peer{receiveBatch.address(i), receiveBatch.addressLength(i)};
+                    printAddressMessageToStdout("Rx << " + std::string{payload, length}, peer);
+                }
+                iovec response[3]{
+                    {const_cast<char *>(RESPONSE_PREFIX.data()), RESPONSE_PREFIX.length()},
+                    {const_cast<char *>(payload), length},
+                    {const_cast<char *>(RESPONSE_SUFFIX.data()), RESPONSE_SUFFIX.length()}
+                };
+                if (!sendBatch.add(response, 3, receiveBatch.address(i), receiveBatch.addressLength(i))) {
+                    sendBatch.send(reactor.listenDescriptor);
+                    sendBatch.add(response, 3, receiveBatch.address(i), receiveBatch.addressLength(i));
+                }
+            }
+        }
+        //Responses point into the receive batch, so they must go out before the next recvmmsg()
+        if ( (!sendBatch.empty()) && (sendBatch.send(reactor.listenDescriptor) == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK) ) {
+            printToStdout(TStringFormat("sendmmsg(int, mmsghdr *, unsigned int, int): error code {0} ({1})", errno, strerror(errno)));
+        }
+        if (static_cast<size_t>(receiveResult) < receiveBatch.batchSize()) {
+            break;
+        }
+    }
 }
 
-void printAddressMessageToStdout(const std::string &msg, sockaddr *address)
+bool setNonBlocking(int socketDescriptor)
 {
-    printToStdout(msg + " - " + sockaddrToString(address));
+    auto flags = fcntl(socketDescriptor, F_GETFL, 0);
+    if (flags == -1) {
+        return false;
+    }
+    return (fcntl(socketDescriptor, F_SETFL, flags | O_NONBLOCK) != -1);
+}
+
+void raiseFileDescriptorLimit()
+{
+    //Every idle connection costs a descriptor, so use everything the hard limit allows
+    rlimit descriptorLimit{};
+    if (getrlimit(RLIMIT_NOFILE, &descriptorLimit) == -1) {
+        return;
+    }
+    if (descriptorLimit.rlim_cur < descriptorLimit.rlim_max) {
+        auto previousLimit = descriptorLimit.rlim_cur;
+        descriptorLimit.rlim_cur = descriptorLimit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &descriptorLimit) == -1) {
+            LOG_WARN() << TStringFormat("setrlimit(int, const rlimit *): error code {0} ({1})", errno, strerror(errno));
+            descriptorLimit.rlim_cur = previousLimit;
+        }
+    }
+    LOG_INFO() << TStringFormat("Using descriptor limit {0}", descriptorLimit.rlim_cur);
+}
+
+void printAddressMessageToStdout(const std::string &msg, const CppSerialPort::PeerAddress &peer)
+{
+    printToStdout(msg + " - " + peer.toString());
 }
 
 void printToStdout(const std::string &msg)
 {
+    if (trafficLog.isRunning()) {
+        trafficLog.write(msg);
+        return;
+    }
     std::lock_guard<std::mutex> coutLock{coutMutex};
     (void)coutLock;
     std::cout << msg << std::endl;
 }
 
-void exitApplication(int exitCode) 
+void exitApplication(int exitCode)
 {
-    if (socketFileDescriptor) {
-        close(*socketFileDescriptor);
+    for (const auto &it : datagramReactors) {
+        if (it->listenDescriptor != -1) {
+            close(it->listenDescriptor);
+        }
+        if (it->stopDescriptor != -1) {
+            close(it->stopDescriptor);
+        }
+    }
+    tcpServer.reset();
+    if (fileRootDescriptor != -1) {
+        close(fileRootDescriptor);
     }
     freeaddrinfo(addressInfo);
+    trafficLog.stop();
     exit(exitCode);
 }
 
 void signalHandler(int signal)
 {
-    if ( (signal == SIGUSR1) || (signal == SIGUSR2) ) {
+    //sendfile() cannot suppress SIGPIPE, a peer that resets mid-file shows up as EPIPE instead
+    if ( (signal == SIGUSR1) || (signal == SIGUSR2) || (signal == SIGPIPE) ) {
         return;
     }
+    //The interrupted thread may be about to read errno
+    auto savedErrno = errno;
     LOG_INFO() << TStringFormat("Signal received: {0} ({1})", signal, strsignal(signal));
+    //The server closes its connections and returns from run() once every reactor has stopped
+    if ( (tcpServer) && (tcpServer->isRunning()) ) {
+        stopSignal = signal;
+        tcpServer->stop();
+        errno = savedErrno;
+        return;
+    }
+    //Likewise every datagram reactor, runUdpServer() joins their threads before main() exits
+    if (datagramReactorsRunning) {
+        stopSignal = signal;
+        for (const auto &it : datagramReactors) {
+            uint64_t wakeup{1};
+            auto writeResult = ::write(it->stopDescriptor, &wakeup, sizeof(wakeup));
+            (void)writeResult;
+        }
+        errno = savedErrno;
+        return;
+    }
     exitApplication(EXIT_FAILURE);
 }
 
-
 void displayVersion()
 {
     using namespace ApplicationUtilities;
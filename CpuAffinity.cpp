@@ -0,0 +1,189 @@
+#include "CpuAffinity.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <cctype>
+
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#if !defined(SO_INCOMING_CPU)
+#    define SO_INCOMING_CPU 49
+#endif //!defined(SO_INCOMING_CPU)
+
+//Memory policy modes from <linux/mempolicy.h>, spelled out so libnuma headers are not needed
+#define CPU_AFFINITY_MPOL_PREFERRED 1
+//Enough for any node count the kernel allows, plus the extra bit set_mempolicy() expects
+#define CPU_AFFINITY_MAXIMUM_NODES 1024
+
+namespace CppSerialPort {
+
+static std::string readFirstLine(const std::string &filePath)
+{
+    std::ifstream file{filePath};
+    std::string line{""};
+    std::getline(file, line);
+    return line;
+}
+
+static std::string errorMessage(const std::string &call)
+{
+    return call + ": error code " + std::to_string(errno) + " (" + strerror(errno) + ')';
+}
+
+CpuAffinity::ThreadBinding::ThreadBinding(int cpu) :
+    m_previousCpus{},
+    m_restoreCpus{false},
+    m_previousPolicy{0},
+    m_previousNodes(CPU_AFFINITY_MAXIMUM_NODES / (8 * sizeof(unsigned long)), 0),
+    m_restorePolicy{false},
+    m_errors{}
+{
+    if ( (cpu < 0) || (cpu >= CPU_SETSIZE) ) {
+        this->m_errors.push_back("CPU " + std::to_string(cpu) + " is out of range");
+        return;
+    }
+    auto thread = pthread_self();
+    auto getResult = pthread_getaffinity_np(thread, sizeof(this->m_previousCpus), &this->m_previousCpus);
+    cpu_set_t cpus{};
+    CPU_ZERO(&cpus);
+    CPU_SET(static_cast<size_t>(cpu), &cpus);
+    auto setResult = ( (getResult == 0) ? pthread_setaffinity_np(thread, sizeof(cpus), &cpus) : getResult );
+    if (setResult != 0) {
+        errno = setResult;
+        this->m_errors.push_back(errorMessage("pthread_setaffinity_np(pthread_t, size_t, const cpu_set_t *) CPU " + std::to_string(cpu)));
+        return;
+    }
+    this->m_restoreCpus = true;
+    auto node = numaNodeOfCpu(cpu);
+    if (node < 0) {
+        return;
+    }
+    if (syscall(SYS_get_mempolicy, &this->m_previousPolicy, this->m_previousNodes.data(), CPU_AFFINITY_MAXIMUM_NODES + 1, nullptr, 0) == -1) {
+        this->m_errors.push_back(errorMessage("get_mempolicy(int *, unsigned long *, unsigned long, void *, unsigned long)"));
+        return;
+    }
+    //Preferred rather than bound, so a full node spills over instead of failing allocations
+    std::vector<unsigned long> nodes(this->m_previousNodes.size(), 0);
+    nodes[static_cast<size_t>(node) / (8 * sizeof(unsigned long))] |= (1UL << (static_cast<size_t>(node) % (8 * sizeof(unsigned long))));
+    if (syscall(SYS_set_mempolicy, CPU_AFFINITY_MPOL_PREFERRED, nodes.data(), CPU_AFFINITY_MAXIMUM_NODES + 1) == -1) {
+        this->m_errors.push_back(errorMessage("set_mempolicy(int, const unsigned long *, unsigned long) node " + std::to_string(node)));
+        return;
+    }
+    this->m_restorePolicy = true;
+}
+
+CpuAffinity::ThreadBinding::~ThreadBinding()
+{
+    if (this->m_restorePolicy) {
+        (void)syscall(SYS_set_mempolicy, this->m_previousPolicy, this->m_previousNodes.data(), CPU_AFFINITY_MAXIMUM_NODES + 1);
+    }
+    if (this->m_restoreCpus) {
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(this->m_previousCpus), &this->m_previousCpus);
+    }
+}
+
+const std::vector<std::string> &CpuAffinity::ThreadBinding::errors() const
+{
+    return this->m_errors;
+}
+
+std::vector<int> CpuAffinity::parseCpuList(const std::string &cpuList)
+{
+    auto fail = [&cpuList]() {
+        throw std::runtime_error("CppSerialPort::CpuAffinity::parseCpuList(const std::string &): \"" + cpuList + "\" is not a CPU list (ex. 0-3,8,10-11)");
+    };
+    std::vector<int> cpus{};
+    size_t position{0};
+    while (position < cpuList.length()) {
+        auto end = cpuList.find(',', position);
+        auto range = cpuList.substr(position, ((end == std::string::npos) ? cpuList.length() : end) - position);
+        position = ((end == std::string::npos) ? cpuList.length() : end + 1);
+        char *rest{nullptr};
+        auto first = strtol(range.c_str(), &rest, 10);
+        auto last = first;
+        if (*rest == '-') {
+            last = strtol(rest + 1, &rest, 10);
+        }
+        if ( (range.empty()) || (*rest != '\0') || (first < 0) || (last < first) || (last >= CPU_SETSIZE) ) {
+            fail();
+        }
+        for (auto cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    if (cpus.empty()) {
+        fail();
+    }
+    return cpus;
+}
+
+std::string CpuAffinity::toCpuList(const std::vector<int> &cpus)
+{
+    std::string returnString{""};
+    for (size_t i = 0; i < cpus.size(); i++) {
+        //Runs of consecutive CPUs collapse into a range
+        auto last = i;
+        while ( ((last + 1) < cpus.size()) && (cpus[last + 1] == (cpus[last] + 1)) ) {
+            last++;
+        }
+        returnString += (returnString.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (last > i) {
+            returnString += '-' + std::to_string(cpus[last]);
+        }
+        i = last;
+    }
+    return returnString;
+}
+
+std::vector<int> CpuAffinity::numaNodeCores(int node)
+{
+    auto cpuList = readFirstLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (cpuList.empty()) {
+        return std::vector<int>{};
+    }
+    std::vector<int> cores{};
+    for (auto cpu : parseCpuList(cpuList)) {
+        auto siblings = readFirstLine("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+        //Two workers on SMT siblings would share one core's caches and execution units
+        if ( (siblings.empty()) || (parseCpuList(siblings).front() == cpu) ) {
+            cores.push_back(cpu);
+        }
+    }
+    return cores;
+}
+
+int CpuAffinity::numaNodeOfCpu(int cpu)
+{
+    //The CPU's sysfs directory links to its node as nodeN
+    auto directory = opendir(("/sys/devices/system/cpu/cpu" + std::to_string(cpu)).c_str());
+    if (directory == nullptr) {
+        return -1;
+    }
+    int returnValue{-1};
+    while (auto entry = readdir(directory)) {
+        char *rest{nullptr};
+        if ( (strncmp(entry->d_name, "node", 4) == 0) && (isdigit(static_cast<unsigned char>(entry->d_name[4]))) ) {
+            auto node = strtol(entry->d_name + 4, &rest, 10);
+            if (*rest == '\0') {
+                returnValue = static_cast<int>(node);
+                break;
+            }
+        }
+    }
+    closedir(directory);
+    return returnValue;
+}
+
+bool CpuAffinity::setIncomingCpu(int socketDescriptor, int cpu)
+{
+    return (setsockopt(socketDescriptor, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) != -1);
+}
+
+} //namespace CppSerialPort
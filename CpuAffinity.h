@@ -0,0 +1,58 @@
+#ifndef CPPSERIALPORT_CPUAFFINITY_H
+#define CPPSERIALPORT_CPUAFFINITY_H
+
+#include <string>
+#include <vector>
+
+#include <sched.h>
+
+namespace CppSerialPort {
+
+/*
+ * CPU pinning and NUMA placement for long lived threads. The topology comes
+ * from sysfs, so a kernel without NUMA support looks like one node holding
+ * every CPU. Memory stays local through the thread's memory policy rather
+ * than libnuma: once a thread prefers its CPU's node, every page it touches
+ * first (its buffers, connection state, malloc arena) comes from that node
+ */
+class CpuAffinity
+{
+public:
+    //Pins the constructing thread to one CPU and prefers that CPU's node for its memory.
+    //Destruction restores the previous affinity and memory policy, so a borrowed thread
+    //leaves as it came. Best effort, errors() lists whatever did not take
+    class ThreadBinding
+    {
+    public:
+        explicit ThreadBinding(int cpu);
+        ~ThreadBinding();
+        ThreadBinding(const ThreadBinding &) = delete;
+        ThreadBinding &operator=(const ThreadBinding &) = delete;
+
+        const std::vector<std::string> &errors() const;
+
+    private:
+        cpu_set_t m_previousCpus;
+        bool m_restoreCpus;
+        int m_previousPolicy;
+        std::vector<unsigned long> m_previousNodes;
+        bool m_restorePolicy;
+        std::vector<std::string> m_errors;
+    };
+
+    //Accepts the kernel's list format (ex. 0-3,8,10-11) and throws on anything else
+    static std::vector<int> parseCpuList(const std::string &cpuList);
+    static std::string toCpuList(const std::vector<int> &cpus);
+    //One CPU per physical core of the node, the first of its SMT siblings. Empty if the node does not exist
+    static std::vector<int> numaNodeCores(int node);
+    //-1 if sysfs does not say
+    static int numaNodeOfCpu(int cpu);
+    //Steers connections whose packets are received on cpu to this SO_REUSEPORT listener, so a worker pinned
+    //there handles them where their RX interrupts land. The kernel honours it within a reuseport group from
+    //Linux 6.2, and connections arriving on other CPUs still get spread by hash. Returns false (errno set) on failure
+    static bool setIncomingCpu(int socketDescriptor, int cpu);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_CPUAFFINITY_H
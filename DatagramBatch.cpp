@@ -0,0 +1,277 @@
+#include "DatagramBatch.h"
+
+#include <cstring>
+#include <cerrno>
+
+namespace CppSerialPort {
+
+const size_t DatagramReceiveBatch::MAXIMUM_DATAGRAM_SIZE{65535};
+
+namespace {
+    //Kernel limits for one UDP_SEGMENT send
+    const size_t MAXIMUM_SEGMENT_COUNT{64};
+    const size_t MAXIMUM_SEGMENTED_LENGTH{65507};
+    //Segments must fit the path MTU, so only merge datagrams that fit a 1500 byte IPv6 packet
+    const size_t MAXIMUM_SEGMENT_SIZE{1452};
+    const size_t RECEIVE_CONTROL_SIZE{CMSG_SPACE(sizeof(int))};
+    const size_t SEND_CONTROL_SIZE{CMSG_SPACE(sizeof(uint16_t))};
+} //Global namespace
+
+DatagramReceiveBatch::DatagramReceiveBatch(size_t batchSize, size_t datagramSize) :
+    m_batchSize{batchSize},
+    m_datagramSize{datagramSize},
+    m_size{0},
+    m_buffers{new char[batchSize * datagramSize]},
+    m_messages(batchSize),
+    m_vectors(batchSize),
+    m_addresses(batchSize),
+    m_controlBuffers{new char[batchSize * RECEIVE_CONTROL_SIZE]},
+    m_segmentSizes(batchSize, 0)
+{
+    for (size_t i = 0; i < this->m_batchSize; i++) {
+        this->m_vectors[i].iov_base = this->m_buffers.get() + (i * this->m_datagramSize);
+        this->m_vectors[i].iov_len = this->m_datagramSize;
+    }
+}
+
+int DatagramReceiveBatch::receive(int socketDescriptor, int flags)
+{
+    //recvmmsg() overwrites the lengths, so every header is reset before each call
+    for (size_t i = 0; i < this->m_batchSize; i++) {
+        auto &header = this->m_messages[i].msg_hdr;
+        header.msg_name = &this->m_addresses[i];
+        header.msg_namelen = sizeof(sockaddr_storage);
+        header.msg_iov = &this->m_vectors[i];
+        header.msg_iovlen = 1;
+        header.msg_control = this->m_controlBuffers.get() + (i * RECEIVE_CONTROL_SIZE);
+        header.msg_controllen = RECEIVE_CONTROL_SIZE;
+        header.msg_flags = 0;
+        this->m_messages[i].msg_len = 0;
+    }
+    this->m_size = 0;
+    auto receiveResult = recvmmsg(socketDescriptor, this->m_messages.data(), static_cast<unsigned int>(this->m_batchSize), flags, nullptr);
+    if (receiveResult == -1) {
+        return -1;
+    }
+    this->m_size = static_cast<size_t>(receiveResult);
+    for (size_t i = 0; i < this->m_size; i++) {
+        this->m_segmentSizes[i] = 0;
+#if defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+        auto &header = this->m_messages[i].msg_hdr;
+        for (auto controlMessage = CMSG_FIRSTHDR(&header); controlMessage != nullptr; controlMessage = CMSG_NXTHDR(&header, controlMessage)) {
+            if ( (controlMessage->cmsg_level == SOL_UDP) && (controlMessage->cmsg_type == UDP_GRO) ) {
+                int segmentSize{0};
+                memcpy(&segmentSize, CMSG_DATA(controlMessage), sizeof(segmentSize));
+                this->m_segmentSizes[i] = static_cast<size_t>(segmentSize);
+            }
+        }
+#endif //defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+    }
+    return receiveResult;
+}
+
+size_t DatagramReceiveBatch::batchSize() const
+{
+    return this->m_batchSize;
+}
+
+size_t DatagramReceiveBatch::size() const
+{
+    return this->m_size;
+}
+
+const char *DatagramReceiveBatch::data(size_t index) const
+{
+    return static_cast<const char *>(this->m_vectors[index].iov_base);
+}
+
+size_t DatagramReceiveBatch::length(size_t index) const
+{
+    return this->m_messages[index].msg_len;
+}
+
+size_t DatagramReceiveBatch::segmentSize(size_t index) const
+{
+    return (this->m_segmentSizes[index] == 0) ? this->length(index) : this->m_segmentSizes[index];
+}
+
+bool DatagramReceiveBatch::truncated(size_t index) const
+{
+    return (this->m_messages[index].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+}
+
+const sockaddr *DatagramReceiveBatch::address(size_t index) const
+{
+    return reinterpret_cast<const sockaddr *>(&this->m_addresses[index]);
+}
+
+socklen_t DatagramReceiveBatch::addressLength(size_t index) const
+{
+    return this->m_messages[index].msg_hdr.msg_namelen;
+}
+
+bool DatagramReceiveBatch::enableReceiveOffload(int socketDescriptor)
+{
+#if defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+    int enable{1};
+    return (setsockopt(socketDescriptor, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == 0);
+#else
+    (void)socketDescriptor;
+    errno = ENOPROTOOPT;
+    return false;
+#endif //defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+}
+
+DatagramSendBatch::DatagramSendBatch(size_t batchSize, bool segmentationOffload) :
+    m_batchSize{batchSize},
+#if defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+    m_segmentationOffload{segmentationOffload},
+#else
+    m_segmentationOffload{false},
+#endif //defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+    m_datagramCount{0},
+    m_messages{},
+    m_vectors{},
+    m_headers(batchSize),
+    m_controlBuffers{new char[batchSize * SEND_CONTROL_SIZE]}
+{
+    (void)segmentationOffload;
+    this->m_messages.reserve(batchSize);
+}
+
+bool DatagramSendBatch::canMerge(const Message &message, size_t length, const sockaddr *address, socklen_t addressLength) const
+{
+    //Every segment but the last must be exactly segmentSize long
+    return (this->m_segmentationOffload) &&
+           (message.lastSegmentLength == message.segmentSize) &&
+           (length <= message.segmentSize) &&
+           (length > 0) &&
+           (message.segmentSize <= MAXIMUM_SEGMENT_SIZE) &&
+           (message.segmentCount < MAXIMUM_SEGMENT_COUNT) &&
+           ((message.totalLength + length) <= MAXIMUM_SEGMENTED_LENGTH) &&
+           (message.addressLength == addressLength) &&
+           ((addressLength == 0) || (memcmp(&message.address, address, addressLength) == 0));
+}
+
+bool DatagramSendBatch::add(const iovec *vectors, size_t count, const sockaddr *address, socklen_t addressLength)
+{
+    if (address == nullptr) {
+        addressLength = 0;
+    }
+    size_t length{0};
+    for (size_t i = 0; i < count; i++) {
+        length += vectors[i].iov_len;
+    }
+    if ( (!this->m_messages.empty()) && (this->canMerge(this->m_messages.back(), length, address, addressLength)) ) {
+        auto &message = this->m_messages.back();
+        this->m_vectors.insert(this->m_vectors.end(), vectors, vectors + count);
+        message.vectorCount += count;
+        message.segmentCount++;
+        message.lastSegmentLength = length;
+        message.totalLength += length;
+        this->m_datagramCount++;
+        return true;
+    }
+    if (this->m_messages.size() >= this->m_batchSize) {
+        return false;
+    }
+    Message message{};
+    message.vectorOffset = this->m_vectors.size();
+    message.vectorCount = count;
+    if (addressLength > sizeof(message.address)) {
+        addressLength = sizeof(message.address);
+    }
+    if (addressLength > 0) {
+        memcpy(&message.address, address, addressLength);
+    }
+    message.addressLength = addressLength;
+    message.segmentSize = length;
+    message.segmentCount = 1;
+    message.lastSegmentLength = length;
+    message.totalLength = length;
+    this->m_vectors.insert(this->m_vectors.end(), vectors, vectors + count);
+    this->m_messages.push_back(message);
+    this->m_datagramCount++;
+    return true;
+}
+
+int DatagramSendBatch::send(int socketDescriptor, int flags)
+{
+    //Headers are built here, since m_vectors may have moved while datagrams were added
+    for (size_t i = 0; i < this->m_messages.size(); i++) {
+        auto &message = this->m_messages[i];
+        auto &header = this->m_headers[i].msg_hdr;
+        header = msghdr{};
+        //A connected socket needs no destination
+        header.msg_name = (message.addressLength == 0) ? nullptr : &message.address;
+        header.msg_namelen = message.addressLength;
+        header.msg_iov = this->m_vectors.data() + message.vectorOffset;
+        header.msg_iovlen = message.vectorCount;
+        this->m_headers[i].msg_len = 0;
+#if defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+        if (message.segmentCount > 1) {
+            header.msg_control = this->m_controlBuffers.get() + (i * SEND_CONTROL_SIZE);
+            header.msg_controllen = SEND_CONTROL_SIZE;
+            auto controlMessage = CMSG_FIRSTHDR(&header);
+            controlMessage->cmsg_level = SOL_UDP;
+            controlMessage->cmsg_type = UDP_SEGMENT;
+            controlMessage->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            auto segmentSize = static_cast<uint16_t>(message.segmentSize);
+            memcpy(CMSG_DATA(controlMessage), &segmentSize, sizeof(segmentSize));
+        }
+#endif //defined(CPPSERIALPORT_HAS_UDP_OFFLOAD)
+    }
+    size_t sentMessages{0};
+    int errorCode{0};
+    while (sentMessages < this->m_messages.size()) {
+        auto sendResult = sendmmsg(socketDescriptor, this->m_headers.data() + sentMessages, static_cast<unsigned int>(this->m_messages.size() - sentMessages), flags);
+        if (sendResult == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            errorCode = errno;
+            break;
+        }
+        sentMessages += static_cast<size_t>(sendResult);
+    }
+    int returnValue{0};
+    for (size_t i = 0; i < sentMessages; i++) {
+        returnValue += static_cast<int>(this->m_messages[i].segmentCount);
+    }
+    //Datagrams that could not be sent are dropped, as the network would
+    this->clear();
+    if ( (sentMessages == 0) && (errorCode != 0) ) {
+        errno = errorCode;
+        return -1;
+    }
+    return returnValue;
+}
+
+void DatagramSendBatch::clear()
+{
+    this->m_messages.clear();
+    this->m_vectors.clear();
+    this->m_datagramCount = 0;
+}
+
+size_t DatagramSendBatch::batchSize() const
+{
+    return this->m_batchSize;
+}
+
+size_t DatagramSendBatch::size() const
+{
+    return this->m_datagramCount;
+}
+
+bool DatagramSendBatch::empty() const
+{
+    return this->m_messages.empty();
+}
+
+bool DatagramSendBatch::segmentationOffload() const
+{
+    return this->m_segmentationOffload;
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,110 @@
+#ifndef CPPSERIALPORT_DATAGRAMBATCH_H
+#define CPPSERIALPORT_DATAGRAMBATCH_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#if defined(UDP_SEGMENT) && defined(UDP_GRO)
+#    define CPPSERIALPORT_HAS_UDP_OFFLOAD
+#endif //defined(UDP_SEGMENT) && defined(UDP_GRO)
+
+namespace CppSerialPort {
+
+/*
+ * Fixed set of datagram buffers filled by one recvmmsg() call. With UDP_GRO
+ * enabled on the socket, one entry may hold several coalesced datagrams of
+ * segmentSize() bytes each (the last one may be shorter)
+ */
+class DatagramReceiveBatch
+{
+public:
+    DatagramReceiveBatch(size_t batchSize, size_t datagramSize = MAXIMUM_DATAGRAM_SIZE);
+    DatagramReceiveBatch(const DatagramReceiveBatch &) = delete;
+    DatagramReceiveBatch &operator=(const DatagramReceiveBatch &) = delete;
+
+    //Returns the number of entries received, or -1 with errno set
+    int receive(int socketDescriptor, int flags = MSG_DONTWAIT);
+
+    size_t batchSize() const;
+    size_t size() const;
+    const char *data(size_t index) const;
+    size_t length(size_t index) const;
+    size_t segmentSize(size_t index) const;
+    bool truncated(size_t index) const;
+    const sockaddr *address(size_t index) const;
+    socklen_t addressLength(size_t index) const;
+
+    static bool enableReceiveOffload(int socketDescriptor);
+
+    static const size_t MAXIMUM_DATAGRAM_SIZE;
+
+private:
+    size_t m_batchSize;
+    size_t m_datagramSize;
+    size_t m_size;
+    std::unique_ptr<char[]> m_buffers;
+    std::vector<mmsghdr> m_messages;
+    std::vector<iovec> m_vectors;
+    std::vector<sockaddr_storage> m_addresses;
+    std::unique_ptr<char[]> m_controlBuffers;
+    std::vector<size_t> m_segmentSizes;
+};
+
+/*
+ * Outgoing datagrams sent with one sendmmsg() call. Each datagram is gathered
+ * from iovecs that must stay valid until send() returns. With segmentation
+ * offload, consecutive datagrams to the same peer are merged into one UDP_SEGMENT
+ * message when the kernel can split them back into the same datagrams
+ */
+class DatagramSendBatch
+{
+public:
+    explicit DatagramSendBatch(size_t batchSize, bool segmentationOffload = false);
+    DatagramSendBatch(const DatagramSendBatch &) = delete;
+    DatagramSendBatch &operator=(const DatagramSendBatch &) = delete;
+
+    //Returns false if the batch is full, send() it and add again. A null address sends to the connected peer
+    bool add(const iovec *vectors, size_t count, const sockaddr *address, socklen_t addressLength);
+    //Returns the number of datagrams sent, or -1 with errno set if none could be sent. The batch is empty afterwards
+    int send(int socketDescriptor, int flags = MSG_DONTWAIT);
+    void clear();
+
+    size_t batchSize() const;
+    size_t size() const;
+    bool empty() const;
+    bool segmentationOffload() const;
+
+private:
+    struct Message
+    {
+        size_t vectorOffset;
+        size_t vectorCount;
+        sockaddr_storage address;
+        socklen_t addressLength;
+        size_t segmentSize;
+        size_t segmentCount;
+        size_t lastSegmentLength;
+        size_t totalLength;
+    };
+
+    size_t m_batchSize;
+    bool m_segmentationOffload;
+    size_t m_datagramCount;
+    std::vector<Message> m_messages;
+    std::vector<iovec> m_vectors;
+    std::vector<mmsghdr> m_headers;
+    std::unique_ptr<char[]> m_controlBuffers;
+
+    bool canMerge(const Message &message, size_t length, const sockaddr *address, socklen_t addressLength) const;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_DATAGRAMBATCH_H
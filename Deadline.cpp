@@ -0,0 +1,60 @@
+#include "Deadline.h"
+
+#include <climits>
+
+namespace CppSerialPort {
+
+Deadline::Deadline(std::chrono::milliseconds timeout) :
+    m_expiry{Clock::now() + timeout}
+{
+
+}
+
+Deadline::Deadline(Clock::time_point expiry) :
+    m_expiry{expiry}
+{
+
+}
+
+Deadline Deadline::never()
+{
+    return Deadline{Clock::time_point::max()};
+}
+
+Deadline::Clock::time_point Deadline::expiry() const
+{
+    return this->m_expiry;
+}
+
+bool Deadline::isNever() const
+{
+    return (this->m_expiry == Clock::time_point::max());
+}
+
+bool Deadline::expired() const
+{
+    return ( (!this->isNever()) && (Clock::now() >= this->m_expiry) );
+}
+
+std::chrono::milliseconds Deadline::remaining() const
+{
+    if (this->isNever()) {
+        return std::chrono::milliseconds::max();
+    }
+    auto remaining = this->m_expiry - Clock::now();
+    if (remaining <= Clock::duration::zero()) {
+        return std::chrono::milliseconds{0};
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(remaining + std::chrono::milliseconds{1} - Clock::duration{1});
+}
+
+int Deadline::pollTimeout() const
+{
+    if (this->isNever()) {
+        return -1;
+    }
+    auto remaining = this->remaining().count();
+    return static_cast<int>((remaining > INT_MAX) ? INT_MAX : remaining);
+}
+
+} //namespace CppSerialPort
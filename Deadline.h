@@ -0,0 +1,42 @@
+#ifndef CPPSERIALPORT_DEADLINE_H
+#define CPPSERIALPORT_DEADLINE_H
+
+#include <chrono>
+
+namespace CppSerialPort {
+
+/*
+ * The point on the monotonic clock by which a blocking call has to return.
+ * steady_clock cannot be stepped by NTP or by someone setting the date, so an
+ * elapsed time measured against it is real. One Deadline is taken when a call
+ * starts and handed to every wait the call makes, each of which waits only for
+ * what is left, so retries and partial reads never stretch the whole call past
+ * its timeout
+ */
+class Deadline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //Expires timeout from now
+    explicit Deadline(std::chrono::milliseconds timeout);
+    Deadline(Clock::time_point expiry);
+    //Never expires, for waits bounded only by the kernel
+    static Deadline never();
+
+    Clock::time_point expiry() const;
+    bool isNever() const;
+    bool expired() const;
+    //Rounded up, so waiting out the remainder never wakes up a fraction of a millisecond early and spins.
+    //0 once expired
+    std::chrono::milliseconds remaining() const;
+    //remaining() as the timeout argument of poll(), -1 for never()
+    int pollTimeout() const;
+
+private:
+    Clock::time_point m_expiry;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_DEADLINE_H
@@ -0,0 +1,68 @@
+#include "DelimiterScanner.h"
+
+#include <stdexcept>
+#include <cstring>
+
+namespace CppSerialPort {
+
+const size_t DelimiterScanner::npos{std::string::npos};
+
+DelimiterScanner::DelimiterScanner(const std::string &delimiter) :
+    m_delimiter{delimiter},
+    m_fallback(delimiter.length(), 0),
+    m_matched{0}
+{
+    if (delimiter.empty()) {
+        throw std::runtime_error("CppSerialPort::DelimiterScanner::DelimiterScanner(const std::string &): invariant failure (delimiter cannot be empty)");
+    }
+    size_t matched{0};
+    for (size_t i = 1; i < delimiter.length(); i++) {
+        while ( (matched > 0) && (delimiter[i] != delimiter[matched]) ) {
+            matched = this->m_fallback[matched - 1];
+        }
+        if (delimiter[i] == delimiter[matched]) {
+            matched++;
+        }
+        this->m_fallback[i] = matched;
+    }
+}
+
+size_t DelimiterScanner::scan(const char *data, size_t length)
+{
+    size_t position{0};
+    while (position < length) {
+        if (this->m_matched == 0) {
+            auto first = static_cast<const char *>(memchr(data + position, this->m_delimiter[0], length - position));
+            if (first == nullptr) {
+                return npos;
+            }
+            position = static_cast<size_t>(first - data) + 1;
+            this->m_matched = 1;
+        } else {
+            auto c = data[position++];
+            while ( (this->m_matched > 0) && (c != this->m_delimiter[this->m_matched]) ) {
+                this->m_matched = this->m_fallback[this->m_matched - 1];
+            }
+            if (c == this->m_delimiter[this->m_matched]) {
+                this->m_matched++;
+            }
+        }
+        if (this->m_matched == this->m_delimiter.length()) {
+            this->m_matched = 0;
+            return position;
+        }
+    }
+    return npos;
+}
+
+void DelimiterScanner::reset()
+{
+    this->m_matched = 0;
+}
+
+const std::string &DelimiterScanner::delimiter() const
+{
+    return this->m_delimiter;
+}
+
+} //namespace CppSerialPort
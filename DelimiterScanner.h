@@ -0,0 +1,42 @@
+#ifndef CPPSERIALPORT_DELIMITERSCANNER_H
+#define CPPSERIALPORT_DELIMITERSCANNER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+/*
+ * Finds a delimiter in data that arrives in pieces. The first byte is found
+ * with memchr(), which the C library vectorizes (SSE2/AVX2 on x86-64), so
+ * bytes that cannot start a match go by a vector at a time, and a single byte
+ * delimiter never leaves memchr(). From a candidate first byte a multi-byte
+ * delimiter is matched byte by byte, with a KMP fallback table so a delimiter
+ * split across two pieces is still found and no byte is looked at twice
+ */
+class DelimiterScanner
+{
+public:
+    explicit DelimiterScanner(const std::string &delimiter);
+
+    //Returns the offset in data just past the end of the delimiter, which may have started in an
+    //earlier piece, or npos if it does not end in this one
+    size_t scan(const char *data, size_t length);
+    //Forgets a partial match, for when the next piece does not follow on from the last
+    void reset();
+    const std::string &delimiter() const;
+
+    static const size_t npos;
+
+private:
+    std::string m_delimiter;
+    //Longest proper prefix of the delimiter that is also a suffix of its first i + 1 bytes
+    std::vector<size_t> m_fallback;
+    //Delimiter bytes matched at the end of the data scanned so far
+    size_t m_matched;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_DELIMITERSCANNER_H
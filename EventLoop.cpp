@@ -0,0 +1,149 @@
+#include "EventLoop.h"
+
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace CppSerialPort {
+
+const int EventLoop::MAXIMUM_EVENTS_PER_WAIT{256};
+
+EventLoop::EventLoop() :
+    m_epollDescriptor{-1},
+    m_wakeupDescriptor{-1},
+    m_running{false},
+    m_handlers{},
+    m_deferredTasks{},
+    m_events(static_cast<size_t>(MAXIMUM_EVENTS_PER_WAIT)),
+    m_timerWheel{}
+{
+    this->m_epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if (this->m_epollDescriptor == -1) {
+        throw std::runtime_error("CppSerialPort::EventLoop::EventLoop(): epoll_create1(int): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    this->m_wakeupDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->m_wakeupDescriptor == -1) {
+        auto errorCode = errno;
+        close(this->m_epollDescriptor);
+        throw std::runtime_error("CppSerialPort::EventLoop::EventLoop(): eventfd(unsigned int, int): error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    }
+    epoll_event wakeupEvent{};
+    wakeupEvent.events = EPOLLIN;
+    wakeupEvent.data.fd = this->m_wakeupDescriptor;
+    if (epoll_ctl(this->m_epollDescriptor, EPOLL_CTL_ADD, this->m_wakeupDescriptor, &wakeupEvent) == -1) {
+        auto errorCode = errno;
+        close(this->m_wakeupDescriptor);
+        close(this->m_epollDescriptor);
+        throw std::runtime_error("CppSerialPort::EventLoop::EventLoop(): epoll_ctl(int, int, int, epoll_event *): error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    close(this->m_wakeupDescriptor);
+    close(this->m_epollDescriptor);
+}
+
+void EventLoop::addDescriptor(int descriptor, uint32_t events, IEventHandler *handler)
+{
+    if ( (descriptor < 0) || (handler == nullptr) ) {
+        throw std::runtime_error("CppSerialPort::EventLoop::addDescriptor(int, uint32_t, IEventHandler *): invariant failure (descriptor must be valid and handler must not be null)");
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = descriptor;
+    if (epoll_ctl(this->m_epollDescriptor, EPOLL_CTL_ADD, descriptor, &event) == -1) {
+        throw std::runtime_error("CppSerialPort::EventLoop::addDescriptor(int, uint32_t, IEventHandler *): epoll_ctl(int, int, int, epoll_event *): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    if (static_cast<size_t>(descriptor) >= this->m_handlers.size()) {
+        this->m_handlers.resize(static_cast<size_t>(descriptor) + 1, nullptr);
+    }
+    this->m_handlers[descriptor] = handler;
+}
+
+void EventLoop::modifyDescriptor(int descriptor, uint32_t events)
+{
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = descriptor;
+    if (epoll_ctl(this->m_epollDescriptor, EPOLL_CTL_MOD, descriptor, &event) == -1) {
+        throw std::runtime_error("CppSerialPort::EventLoop::modifyDescriptor(int, uint32_t): epoll_ctl(int, int, int, epoll_event *): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+}
+
+void EventLoop::removeDescriptor(int descriptor)
+{
+    //Failure here only means the descriptor was already closed, which removes it from the set anyway
+    epoll_ctl(this->m_epollDescriptor, EPOLL_CTL_DEL, descriptor, nullptr);
+    if ( (descriptor >= 0) && (static_cast<size_t>(descriptor) < this->m_handlers.size()) ) {
+        this->m_handlers[descriptor] = nullptr;
+    }
+}
+
+void EventLoop::defer(const std::function<void()> &task)
+{
+    this->m_deferredTasks.push_back(task);
+}
+
+TimerWheel &EventLoop::timerWheel()
+{
+    return this->m_timerWheel;
+}
+
+void EventLoop::run()
+{
+    this->m_running = true;
+    while (this->m_running) {
+        auto eventCount = epoll_wait(this->m_epollDescriptor, this->m_events.data(), MAXIMUM_EVENTS_PER_WAIT, this->m_timerWheel.millisecondsUntilNextTick());
+        if (eventCount == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("CppSerialPort::EventLoop::run(): epoll_wait(int, epoll_event *, int, int): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+        }
+        for (int i = 0; i < eventCount; i++) {
+            auto descriptor = this->m_events[i].data.fd;
+            if (descriptor == this->m_wakeupDescriptor) {
+                uint64_t wakeupCount{0};
+                while (::read(this->m_wakeupDescriptor, &wakeupCount, sizeof(wakeupCount)) > 0) { }
+                continue;
+            }
+            //A handler earlier in this batch may have removed the descriptor
+            if ( (static_cast<size_t>(descriptor) < this->m_handlers.size()) && (this->m_handlers[descriptor] != nullptr) ) {
+                this->m_handlers[descriptor]->handleEvents(descriptor, this->m_events[i].events);
+            }
+        }
+        this->m_timerWheel.advance();
+        this->runDeferredTasks();
+    }
+}
+
+void EventLoop::runDeferredTasks()
+{
+    while (!this->m_deferredTasks.empty()) {
+        std::vector<std::function<void()>> tasks{};
+        tasks.swap(this->m_deferredTasks);
+        for (auto &it : tasks) {
+            it();
+        }
+    }
+}
+
+void EventLoop::stop()
+{
+    this->m_running = false;
+    uint64_t wakeup{1};
+    auto writeResult = ::write(this->m_wakeupDescriptor, &wakeup, sizeof(wakeup));
+    (void)writeResult;
+}
+
+bool EventLoop::isRunning() const
+{
+    return this->m_running;
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,64 @@
+#ifndef CPPSERIALPORT_EVENTLOOP_H
+#define CPPSERIALPORT_EVENTLOOP_H
+
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+#include <sys/epoll.h>
+
+#include "TimerWheel.h"
+
+namespace CppSerialPort {
+
+class IEventHandler
+{
+public:
+    virtual ~IEventHandler() = default;
+    virtual void handleEvents(int descriptor, uint32_t events) = 0;
+};
+
+/*
+ * Edge-triggered epoll reactor. Every descriptor added to the loop must be
+ * non-blocking, and its handler must drain it (until EAGAIN) on each event.
+ * Timers on timerWheel() fire from run(), which only wakes up on a tick while
+ * any are scheduled. All methods except stop() must be called from the thread
+ * running run()
+ */
+class EventLoop
+{
+public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    void addDescriptor(int descriptor, uint32_t events, IEventHandler *handler);
+    void modifyDescriptor(int descriptor, uint32_t events);
+    void removeDescriptor(int descriptor);
+
+    void defer(const std::function<void()> &task);
+    TimerWheel &timerWheel();
+
+    void run();
+    void stop();
+    bool isRunning() const;
+
+private:
+    int m_epollDescriptor;
+    int m_wakeupDescriptor;
+    std::atomic<bool> m_running;
+    std::vector<IEventHandler *> m_handlers;
+    std::vector<std::function<void()>> m_deferredTasks;
+    std::vector<epoll_event> m_events;
+    TimerWheel m_timerWheel;
+
+    void runDeferredTasks();
+
+    static const int MAXIMUM_EVENTS_PER_WAIT;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_EVENTLOOP_H
@@ -0,0 +1,146 @@
+#include "FrameDecoder.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace CppSerialPort {
+
+const size_t FrameDecoder::LENGTH_PREFIX_SIZE{4};
+const size_t FrameDecoder::DEFAULT_MAXIMUM_FRAME_SIZE{1 << 20};
+const char FrameDecoder::LINE_DELIMITER{'\n'};
+
+FrameDecoder::FrameDecoder(FramingMode framingMode, size_t maximumFrameSize) :
+    m_framingMode{framingMode},
+    m_maximumFrameSize{maximumFrameSize},
+    m_pending{},
+    m_pendingLength{0},
+    m_completed{}
+{
+
+}
+
+FramingMode FrameDecoder::framingMode() const
+{
+    return this->m_framingMode;
+}
+
+size_t FrameDecoder::maximumFrameSize() const
+{
+    return this->m_maximumFrameSize;
+}
+
+size_t FrameDecoder::pendingLength() const
+{
+    return this->m_pendingLength;
+}
+
+void FrameDecoder::releaseCompleted()
+{
+    this->m_completed.release();
+}
+
+void FrameDecoder::reset()
+{
+    this->m_pending.release();
+    this->m_pendingLength = 0;
+    this->m_completed.release();
+}
+
+void FrameDecoder::appendPending(const char *data, size_t length)
+{
+    auto required = this->m_pendingLength + length;
+    if (required > this->m_pending.capacity()) {
+        //Long lines double their buffer, length prefixed frames get one big enough for the whole frame once the prefix is in
+        auto capacity = std::max(required, this->m_pending.capacity() * 2);
+        if (this->m_framingMode == FramingMode::LengthPrefixed) {
+            const char *prefix{(this->m_pendingLength >= LENGTH_PREFIX_SIZE) ? this->m_pending.data() : nullptr};
+            if ( (this->m_pendingLength == 0) && (length >= LENGTH_PREFIX_SIZE) ) {
+                prefix = data;
+            }
+            if (prefix != nullptr) {
+                capacity = std::max(required, LENGTH_PREFIX_SIZE + decodeLengthPrefix(prefix));
+            }
+        }
+        auto grown = BufferPool::acquire(capacity);
+        if (this->m_pendingLength > 0) {
+            memcpy(grown.data(), this->m_pending.data(), this->m_pendingLength);
+        }
+        this->m_pending = std::move(grown);
+    }
+    memcpy(this->m_pending.data() + this->m_pendingLength, data, length);
+    this->m_pendingLength = required;
+}
+
+void FrameDecoder::encodeLengthPrefix(uint32_t length, char *destination)
+{
+    destination[0] = static_cast<char>((length >> 24) & 0xFF);
+    destination[1] = static_cast<char>((length >> 16) & 0xFF);
+    destination[2] = static_cast<char>((length >> 8) & 0xFF);
+    destination[3] = static_cast<char>(length & 0xFF);
+}
+
+uint32_t FrameDecoder::decodeLengthPrefix(const char *source)
+{
+    auto bytes = reinterpret_cast<const unsigned char *>(source);
+    return (static_cast<uint32_t>(bytes[0]) << 24) |
+           (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) |
+           static_cast<uint32_t>(bytes[3]);
+}
+
+FrameDecoder::FrameStatus FrameDecoder::findFrame(const char *data, size_t length, Frame &frame) const
+{
+    if (this->m_framingMode == FramingMode::LineDelimited) {
+        auto delimiter = static_cast<const char *>(memchr(data, LINE_DELIMITER, length));
+        if (delimiter == nullptr) {
+            return (length > this->m_maximumFrameSize) ? FrameStatus::TooLarge : FrameStatus::Incomplete;
+        }
+        frame.payloadOffset = 0;
+        frame.payloadLength = static_cast<size_t>(delimiter - data);
+        frame.frameLength = frame.payloadLength + 1;
+        return (frame.payloadLength > this->m_maximumFrameSize) ? FrameStatus::TooLarge : FrameStatus::Complete;
+    }
+    if (length < LENGTH_PREFIX_SIZE) {
+        return FrameStatus::Incomplete;
+    }
+    frame.payloadOffset = LENGTH_PREFIX_SIZE;
+    frame.payloadLength = decodeLengthPrefix(data);
+    frame.frameLength = LENGTH_PREFIX_SIZE + frame.payloadLength;
+    if (frame.payloadLength > this->m_maximumFrameSize) {
+        return FrameStatus::TooLarge;
+    }
+    return (length < frame.frameLength) ? FrameStatus::Incomplete : FrameStatus::Complete;
+}
+
+FrameDecoder::FrameStatus FrameDecoder::findPendingFrame(Frame &frame) const
+{
+    //Pending data only ever grows up to the end of its frame, so a line frame can only end at the last byte
+    if (this->m_framingMode == FramingMode::LineDelimited) {
+        if (this->m_pending.data()[this->m_pendingLength - 1] != LINE_DELIMITER) {
+            return (this->m_pendingLength > this->m_maximumFrameSize) ? FrameStatus::TooLarge : FrameStatus::Incomplete;
+        }
+        frame.payloadOffset = 0;
+        frame.payloadLength = this->m_pendingLength - 1;
+        frame.frameLength = this->m_pendingLength;
+        return (frame.payloadLength > this->m_maximumFrameSize) ? FrameStatus::TooLarge : FrameStatus::Complete;
+    }
+    return this->findFrame(this->m_pending.data(), this->m_pendingLength, frame);
+}
+
+size_t FrameDecoder::bytesToCompletePending(const char *data, size_t length) const
+{
+    if (this->m_framingMode == FramingMode::LineDelimited) {
+        auto delimiter = static_cast<const char *>(memchr(data, LINE_DELIMITER, length));
+        return (delimiter == nullptr) ? length : static_cast<size_t>(delimiter - data) + 1;
+    }
+    //Complete the length prefix on its own first, so an oversized frame is rejected before it is buffered
+    size_t required{0};
+    if (this->m_pendingLength < LENGTH_PREFIX_SIZE) {
+        required = LENGTH_PREFIX_SIZE - this->m_pendingLength;
+    } else {
+        required = LENGTH_PREFIX_SIZE + decodeLengthPrefix(this->m_pending.data()) - this->m_pendingLength;
+    }
+    return (required < length) ? required : length;
+}
+
+} //namespace CppSerialPort
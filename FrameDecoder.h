@@ -0,0 +1,109 @@
+#ifndef CPPSERIALPORT_FRAMEDECODER_H
+#define CPPSERIALPORT_FRAMEDECODER_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "BufferPool.h"
+
+namespace CppSerialPort {
+
+enum class FramingMode {
+    LineDelimited,
+    LengthPrefixed
+};
+
+/*
+ * Incremental stream framer. Every complete frame in a received buffer is
+ * handed to the handler in one pass, straight out of the caller's buffer, and
+ * only a trailing partial frame is copied aside, into a pooled buffer, until the
+ * next read completes it. A decoder between frames holds no buffer at all.
+ * Line delimited frames end in '\n' (not included in the frame), length prefixed
+ * frames start with a 4 byte big endian payload length
+ */
+class FrameDecoder
+{
+public:
+    explicit FrameDecoder(FramingMode framingMode = FramingMode::LineDelimited, size_t maximumFrameSize = DEFAULT_MAXIMUM_FRAME_SIZE);
+
+    //Calls handler(const char *frame, size_t length) for each complete frame, returns false if a frame exceeds the maximum size
+    //Frames point into data or into the decoder, and stay valid until the next call to decode() or reset()
+    template <typename Handler>
+    bool decode(const char *data, size_t length, Handler &&handler)
+    {
+        while ( (this->m_pendingLength > 0) && (length > 0) ) {
+            auto required = this->bytesToCompletePending(data, length);
+            this->appendPending(data, required);
+            data += required;
+            length -= required;
+            Frame frame{};
+            auto frameStatus = this->findPendingFrame(frame);
+            if (frameStatus == FrameStatus::TooLarge) {
+                return false;
+            } else if (frameStatus == FrameStatus::Complete) {
+                this->m_completed = std::move(this->m_pending);
+                this->m_pendingLength = 0;
+                handler(this->m_completed.data() + frame.payloadOffset, frame.payloadLength);
+            }
+        }
+        while (length > 0) {
+            Frame frame{};
+            auto frameStatus = this->findFrame(data, length, frame);
+            if (frameStatus == FrameStatus::TooLarge) {
+                return false;
+            } else if (frameStatus == FrameStatus::Incomplete) {
+                this->appendPending(data, length);
+                break;
+            }
+            handler(data + frame.payloadOffset, frame.payloadLength);
+            data += frame.frameLength;
+            length -= frame.frameLength;
+        }
+        return true;
+    }
+
+    FramingMode framingMode() const;
+    size_t maximumFrameSize() const;
+    size_t pendingLength() const;
+    //Hands the buffer of the last frame completed from pending data back to the pool. Frames from the last decode() are invalid afterwards
+    void releaseCompleted();
+    void reset();
+
+    static void encodeLengthPrefix(uint32_t length, char *destination);
+
+    static const size_t LENGTH_PREFIX_SIZE;
+    static const size_t DEFAULT_MAXIMUM_FRAME_SIZE;
+    static const char LINE_DELIMITER;
+
+private:
+    enum class FrameStatus {
+        Complete,
+        Incomplete,
+        TooLarge
+    };
+
+    struct Frame
+    {
+        size_t payloadOffset;
+        size_t payloadLength;
+        size_t frameLength;
+    };
+
+    FramingMode m_framingMode;
+    size_t m_maximumFrameSize;
+    PooledBuffer m_pending;
+    size_t m_pendingLength;
+    PooledBuffer m_completed;
+
+    void appendPending(const char *data, size_t length);
+
+    FrameStatus findFrame(const char *data, size_t length, Frame &frame) const;
+    FrameStatus findPendingFrame(Frame &frame) const;
+    size_t bytesToCompletePending(const char *data, size_t length) const;
+    static uint32_t decodeLengthPrefix(const char *source);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_FRAMEDECODER_H
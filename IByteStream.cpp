@@ -17,7 +17,9 @@
 
 #include <sstream>
 #include "IByteStream.h"
+#include "DelimiterScanner.h"
 #include <fstream>
+#include <algorithm>
 
 namespace CppSerialPort {
 
@@ -32,11 +34,13 @@ const char *IByteStream::DEFAULT_LINE_ENDING{"\n"};
 
 const int IByteStream::DEFAULT_READ_TIMEOUT{1000};
 const int IByteStream::DEFAULT_WRITE_TIMEOUT{1000};
+const size_t IByteStream::READ_CHUNK_SIZE{4096};
 
 IByteStream::IByteStream() :
 	m_readTimeout{ DEFAULT_READ_TIMEOUT },
 	m_writeTimeout{ DEFAULT_WRITE_TIMEOUT },
 	m_lineEnding{ DEFAULT_LINE_ENDING },
+	m_maximumReadLength{ 0 },
 	m_writeMutex{},
 	m_readMutex{}
 {
@@ -90,6 +94,16 @@ void IByteStream::setLineEnding(char chr)
     this->m_lineEnding = std::string(1, chr);
 }
 
+void IByteStream::setMaximumReadLength(size_t maximumReadLength)
+{
+    this->m_maximumReadLength = maximumReadLength;
+}
+
+size_t IByteStream::maximumReadLength() const
+{
+    return this->m_maximumReadLength;
+}
+
 ssize_t IByteStream::writeLine(const std::string &str)
 {
     std::lock_guard<std::mutex> writeLock{this->m_writeMutex};
@@ -111,21 +125,37 @@ std::string IByteStream::readLine(bool *timeout)
 std::string IByteStream::readUntil(const std::string &until, bool *timeout)
 {
 	std::lock_guard<std::mutex> readLock{ this->m_readMutex };
-    uint64_t startTime{IByteStream::getEpoch()};
+    Deadline deadline{std::chrono::milliseconds{this->m_readTimeout}};
+    DelimiterScanner scanner{until};
     std::string returnString{""};
     if (timeout) {
         *timeout = false;
     }
-    do {
-        int maybeChar{this->read()};
-        if (maybeChar == 0) {
-            continue;
+    char chunk[READ_CHUNK_SIZE];
+    while (true) {
+        //Never reads past the maximum length, so nothing beyond it has to be handed back
+        auto wanted = sizeof(chunk);
+        if (this->m_maximumReadLength != 0) {
+            if (returnString.length() >= this->m_maximumReadLength) {
+                break;
+            }
+            wanted = std::min(wanted, this->m_maximumReadLength - returnString.length());
         }
-        returnString += static_cast<char>(maybeChar);
-        if (endsWith(returnString, until)) {
-            return returnString.substr(0, returnString.length() - until.length());
+        auto readCount = this->readAvailable(chunk, wanted, deadline);
+        //Each chunk is scanned once, a delimiter split across two of them is carried over by the scanner
+        auto end = scanner.scan(chunk, readCount);
+        if (end != DelimiterScanner::npos) {
+            returnString.append(chunk, end);
+            this->putBack(chunk + end, readCount - end);
+            returnString.resize(returnString.length() - until.length());
+            return returnString;
         }
-    } while ((IByteStream::getEpoch() - startTime) <= static_cast<unsigned long>(this->m_readTimeout));
+        returnString.append(chunk, readCount);
+        //Checked after every chunk, a peer that keeps each read full must not hold the call past the read timeout
+        if (deadline.expired()) {
+            break;
+        }
+    }
     if (timeout) {
         *timeout = true;
     }
@@ -137,6 +167,56 @@ std::string IByteStream::readUntil(char until, bool *timeout)
     return this->readUntil(std::string(1, until), timeout);
 }
 
+size_t IByteStream::readSome(char *buffer, size_t length)
+{
+	std::lock_guard<std::mutex> readLock{ this->m_readMutex };
+    return this->readAvailable(buffer, length, Deadline{std::chrono::milliseconds{this->m_readTimeout}});
+}
+
+size_t IByteStream::read(char *buffer, size_t length)
+{
+    return this->readExactly(buffer, length, Deadline{std::chrono::milliseconds{this->m_readTimeout}});
+}
+
+size_t IByteStream::readExactly(char *buffer, size_t length, const Deadline &deadline, bool *timeout)
+{
+	std::lock_guard<std::mutex> readLock{ this->m_readMutex };
+    size_t readCount{0};
+    while (readCount < length) {
+        readCount += this->readAvailable(buffer + readCount, length - readCount, deadline);
+        if ( (readCount < length) && (deadline.expired()) ) {
+            break;
+        }
+    }
+    if (timeout) {
+        *timeout = (readCount < length);
+    }
+    return readCount;
+}
+
+void IByteStream::putBack(const char *data, size_t length)
+{
+    //Last byte first, so they come back out in their original order
+    for (size_t i = length; i > 0; i--) {
+        this->putBack(data[i - 1]);
+    }
+}
+
+size_t IByteStream::readAvailable(char *buffer, size_t length, const Deadline &deadline)
+{
+    (void)deadline;
+    if (length == 0) {
+        return 0;
+    }
+    //read() cannot tell a NUL byte from nothing arriving
+    char maybeChar{this->read()};
+    if (maybeChar == 0) {
+        return 0;
+    }
+    buffer[0] = maybeChar;
+    return 1;
+}
+
 int IByteStream::peek()
 {
     int readChar{this->read()};
@@ -33,6 +33,10 @@
 #include <string>
 #include <sstream>
 #include <mutex>
+#include <chrono>
+#include <cstddef>
+
+#include "Deadline.h"
 
 #if defined(_WIN32)
 #    ifndef PATH_MAX
@@ -74,14 +78,32 @@ public:
 	void setLineEnding(const std::string &str);
 	void setLineEnding(char chr);
 
+	//Bytes readLine() and readUntil() take, delimiter included, before giving up as if they had timed out.
+	//The rest stays unread. 0 (the default) means no limit, only the read timeout bounds the line
+	void setMaximumReadLength(size_t maximumReadLength);
+	size_t maximumReadLength() const;
+
 	virtual ssize_t writeLine(const std::string &str);
 
 	std::string readLine(bool *timeout = nullptr);
 	std::string readUntil(const std::string &until, bool *timeout = nullptr);
 	std::string readUntil(char until, bool *timeout = nullptr);
 
+	//Bulk reads, which take the read lock once per call rather than dispatching once per byte.
+	//readSome() waits at most the read timeout and returns whatever arrived first, 0 if nothing did.
+	//read() and readExactly() keep reading until length bytes are in or time runs out, and return how many are.
+	//Every timeout here is one Deadline on the monotonic clock for the whole call, not one per wait
+	size_t readSome(char *buffer, size_t length);
+	size_t read(char *buffer, size_t length);
+	size_t readExactly(char *buffer, size_t length, const Deadline &deadline, bool *timeout = nullptr);
+
 protected:
 	virtual void putBack(char c) = 0;
+	//Hands back bytes read past what the caller wanted, so they come out first on the next read
+	virtual void putBack(const char *data, size_t length);
+	//Waits until deadline at the latest for data, then copies up to length bytes of it. The default reads one
+	//byte with read(), which waits the read timeout instead; streams with a buffer of their own override it
+	virtual size_t readAvailable(char *buffer, size_t length, const Deadline &deadline);
 
 	static bool fileExists(const std::string &filePath);
 	static inline bool endsWith (const std::string &fullString, const std::string &ending) {
@@ -117,6 +139,7 @@ protected:
 
 	static const int DEFAULT_READ_TIMEOUT;
 	static const int DEFAULT_WRITE_TIMEOUT;
+	//Wall clock milliseconds, which jump when the date is set, so measure timeouts with Deadline instead
 	static uint64_t getEpoch();
 
 
@@ -124,11 +147,13 @@ private:
     int m_readTimeout;
     int m_writeTimeout;
     std::string m_lineEnding;
+    size_t m_maximumReadLength;
     std::mutex m_writeMutex;
 	std::mutex m_readMutex;
 
 
     static const char *DEFAULT_LINE_ENDING;
+    static const size_t READ_CHUNK_SIZE;
 
     ssize_t write(const std::string &str);
 };
@@ -0,0 +1,231 @@
+#include "IoUring.h"
+
+#if defined(CPPSERIALPORT_HAS_IO_URING)
+
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace CppSerialPort {
+
+namespace {
+    int ioUringSetup(unsigned entries, io_uring_params *parameters) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, parameters));
+    }
+
+    int ioUringEnter(int ringDescriptor, unsigned toSubmit, unsigned minimumComplete, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ringDescriptor, toSubmit, minimumComplete, flags, nullptr, 0));
+    }
+
+    int ioUringRegister(int ringDescriptor, unsigned opcode, void *argument, unsigned argumentCount) {
+        return static_cast<int>(syscall(__NR_io_uring_register, ringDescriptor, opcode, argument, argumentCount));
+    }
+} //Global namespace
+
+IoUring::IoUring(unsigned entries) :
+    m_ringDescriptor{-1},
+    m_parameters{},
+    m_ringMemory{MAP_FAILED},
+    m_ringMemorySize{0},
+    m_submissionEntries{nullptr},
+    m_submissionEntriesSize{0},
+    m_submissionHead{nullptr},
+    m_submissionTail{nullptr},
+    m_submissionRingMask{nullptr},
+    m_submissionArray{nullptr},
+    m_submissionLocalTail{0},
+    m_submissionSubmitted{0},
+    m_completionHead{nullptr},
+    m_completionTail{nullptr},
+    m_completionRingMask{nullptr},
+    m_completionEntries{nullptr},
+    m_bufferRing{nullptr},
+    m_bufferRingSize{0},
+    m_bufferStorage{},
+    m_bufferCount{0},
+    m_bufferSize{0},
+    m_bufferGroup{0}
+{
+    //Single issuer with deferred task running keeps completion work on this thread,
+    //older kernels reject the flags, so retry without them
+    memset(&this->m_parameters, 0, sizeof(this->m_parameters));
+    this->m_parameters.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    this->m_ringDescriptor = ioUringSetup(entries, &this->m_parameters);
+    if ( (this->m_ringDescriptor == -1) && (errno == EINVAL) ) {
+        memset(&this->m_parameters, 0, sizeof(this->m_parameters));
+        this->m_ringDescriptor = ioUringSetup(entries, &this->m_parameters);
+    }
+    if (this->m_ringDescriptor == -1) {
+        throw std::runtime_error("CppSerialPort::IoUring::IoUring(unsigned): io_uring_setup(unsigned, io_uring_params *): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    if (!(this->m_parameters.features & IORING_FEAT_SINGLE_MMAP)) {
+        this->release();
+        throw std::runtime_error("CppSerialPort::IoUring::IoUring(unsigned): kernel does not support IORING_FEAT_SINGLE_MMAP");
+    }
+
+    auto submissionRingSize = this->m_parameters.sq_off.array + this->m_parameters.sq_entries * sizeof(unsigned);
+    auto completionRingSize = this->m_parameters.cq_off.cqes + this->m_parameters.cq_entries * sizeof(io_uring_cqe);
+    this->m_ringMemorySize = (submissionRingSize > completionRingSize) ? submissionRingSize : completionRingSize;
+    this->m_ringMemory = mmap(nullptr, this->m_ringMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ringDescriptor, IORING_OFF_SQ_RING);
+    if (this->m_ringMemory == MAP_FAILED) {
+        auto errorCode = errno;
+        this->release();
+        throw std::runtime_error("CppSerialPort::IoUring::IoUring(unsigned): mmap(void *, size_t, int, int, int, off_t) rings: error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    }
+    this->m_submissionEntriesSize = this->m_parameters.sq_entries * sizeof(io_uring_sqe);
+    auto submissionEntries = mmap(nullptr, this->m_submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ringDescriptor, IORING_OFF_SQES);
+    if (submissionEntries == MAP_FAILED) {
+        auto errorCode = errno;
+        this->release();
+        throw std::runtime_error("CppSerialPort::IoUring::IoUring(unsigned): mmap(void *, size_t, int, int, int, off_t) entries: error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    }
+    this->m_submissionEntries = static_cast<io_uring_sqe *>(submissionEntries);
+
+    auto ringBase = static_cast<char *>(this->m_ringMemory);
+    this->m_submissionHead = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.sq_off.head);
+    this->m_submissionTail = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.sq_off.tail);
+    this->m_submissionRingMask = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.sq_off.ring_mask);
+    this->m_submissionArray = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.sq_off.array);
+    this->m_completionHead = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.cq_off.head);
+    this->m_completionTail = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.cq_off.tail);
+    this->m_completionRingMask = reinterpret_cast<unsigned *>(ringBase + this->m_parameters.cq_off.ring_mask);
+    this->m_completionEntries = reinterpret_cast<io_uring_cqe *>(ringBase + this->m_parameters.cq_off.cqes);
+    this->m_submissionLocalTail = *this->m_submissionTail;
+    this->m_submissionSubmitted = this->m_submissionLocalTail;
+}
+
+IoUring::~IoUring()
+{
+    this->release();
+}
+
+void IoUring::release()
+{
+    if (this->m_bufferRing) {
+        munmap(this->m_bufferRing, this->m_bufferRingSize);
+        this->m_bufferRing = nullptr;
+    }
+    if (this->m_submissionEntries) {
+        munmap(this->m_submissionEntries, this->m_submissionEntriesSize);
+        this->m_submissionEntries = nullptr;
+    }
+    if (this->m_ringMemory != MAP_FAILED) {
+        munmap(this->m_ringMemory, this->m_ringMemorySize);
+        this->m_ringMemory = MAP_FAILED;
+    }
+    if (this->m_ringDescriptor != -1) {
+        close(this->m_ringDescriptor);
+        this->m_ringDescriptor = -1;
+    }
+}
+
+io_uring_sqe *IoUring::getSubmissionEntry()
+{
+    auto head = __atomic_load_n(this->m_submissionHead, __ATOMIC_ACQUIRE);
+    if ( (this->m_submissionLocalTail - head) >= this->m_parameters.sq_entries ) {
+        this->submit();
+        head = __atomic_load_n(this->m_submissionHead, __ATOMIC_ACQUIRE);
+        if ( (this->m_submissionLocalTail - head) >= this->m_parameters.sq_entries ) {
+            throw std::runtime_error("CppSerialPort::IoUring::getSubmissionEntry(): submission queue is full");
+        }
+    }
+    auto index = this->m_submissionLocalTail & *this->m_submissionRingMask;
+    auto entry = &this->m_submissionEntries[index];
+    memset(entry, 0, sizeof(io_uring_sqe));
+    this->m_submissionArray[index] = index;
+    this->m_submissionLocalTail++;
+    return entry;
+}
+
+int IoUring::submit(unsigned waitCount)
+{
+    auto toSubmit = this->m_submissionLocalTail - this->m_submissionSubmitted;
+    __atomic_store_n(this->m_submissionTail, this->m_submissionLocalTail, __ATOMIC_RELEASE);
+    this->m_submissionSubmitted = this->m_submissionLocalTail;
+    unsigned flags{0};
+    if ( (waitCount > 0) || (this->m_parameters.flags & IORING_SETUP_DEFER_TASKRUN) ) {
+        flags |= IORING_ENTER_GETEVENTS;
+    }
+    while (true) {
+        auto enterResult = ioUringEnter(this->m_ringDescriptor, toSubmit, waitCount, flags);
+        if (enterResult >= 0) {
+            return enterResult;
+        }
+        if (errno == EINTR) {
+            continue;
+        } else if ( (errno == EAGAIN) || (errno == EBUSY) ) {
+            //Completion queue is backed up, the caller must reap before submitting more
+            return 0;
+        }
+        throw std::runtime_error("CppSerialPort::IoUring::submit(unsigned): io_uring_enter(int, unsigned, unsigned, unsigned): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+}
+
+void IoUring::setupBufferRing(uint16_t groupId, unsigned bufferCount, unsigned bufferSize)
+{
+    if ( (bufferCount == 0) || (bufferCount > 32768) || ((bufferCount & (bufferCount - 1)) != 0) ) {
+        throw std::runtime_error("CppSerialPort::IoUring::setupBufferRing(uint16_t, unsigned, unsigned): invariant failure (buffer count must be a power of 2 no larger than 32768, " + std::to_string(bufferCount) + ')');
+    }
+    this->m_bufferRingSize = bufferCount * sizeof(io_uring_buf);
+    auto bufferRing = mmap(nullptr, this->m_bufferRingSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (bufferRing == MAP_FAILED) {
+        throw std::runtime_error("CppSerialPort::IoUring::setupBufferRing(uint16_t, unsigned, unsigned): mmap(void *, size_t, int, int, int, off_t): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    this->m_bufferRing = static_cast<io_uring_buf_ring *>(bufferRing);
+
+    io_uring_buf_reg registration{};
+    memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = reinterpret_cast<uint64_t>(this->m_bufferRing);
+    registration.ring_entries = bufferCount;
+    registration.bgid = groupId;
+    if (ioUringRegister(this->m_ringDescriptor, IORING_REGISTER_PBUF_RING, &registration, 1) == -1) {
+        auto errorCode = errno;
+        munmap(this->m_bufferRing, this->m_bufferRingSize);
+        this->m_bufferRing = nullptr;
+        throw std::runtime_error("CppSerialPort::IoUring::setupBufferRing(uint16_t, unsigned, unsigned): io_uring_register(int, unsigned, void *, unsigned): error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    }
+    this->m_bufferCount = bufferCount;
+    this->m_bufferSize = bufferSize;
+    this->m_bufferGroup = groupId;
+    this->m_bufferStorage.resize(static_cast<size_t>(bufferCount) * bufferSize);
+    for (unsigned i = 0; i < bufferCount; i++) {
+        this->recycleBuffer(static_cast<uint16_t>(i));
+    }
+}
+
+char *IoUring::buffer(uint16_t bufferId)
+{
+    return this->m_bufferStorage.data() + (static_cast<size_t>(bufferId) * this->m_bufferSize);
+}
+
+void IoUring::recycleBuffer(uint16_t bufferId)
+{
+    //The ring tail overlays the reserved field of the first entry. Index from the ring base
+    //rather than through io_uring_buf_ring::bufs, which is misplaced when the uapi header is compiled as C++
+    auto entries = reinterpret_cast<io_uring_buf *>(this->m_bufferRing);
+    auto tail = entries[0].resv;
+    auto &entry = entries[tail & (this->m_bufferCount - 1)];
+    entry.addr = reinterpret_cast<uint64_t>(this->buffer(bufferId));
+    entry.len = this->m_bufferSize;
+    entry.bid = bufferId;
+    __atomic_store_n(&entries[0].resv, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+unsigned IoUring::bufferSize() const
+{
+    return this->m_bufferSize;
+}
+
+uint16_t IoUring::bufferGroup() const
+{
+    return this->m_bufferGroup;
+}
+
+} //namespace CppSerialPort
+
+#endif //defined(CPPSERIALPORT_HAS_IO_URING)
@@ -0,0 +1,95 @@
+#ifndef CPPSERIALPORT_IOURING_H
+#define CPPSERIALPORT_IOURING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#    if __has_include(<linux/io_uring.h>)
+#        include <linux/io_uring.h>
+#        if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT)
+#            define CPPSERIALPORT_HAS_IO_URING 1
+#        endif
+#    endif
+#endif
+
+#if defined(CPPSERIALPORT_HAS_IO_URING)
+
+namespace CppSerialPort {
+
+/*
+ * Minimal io_uring wrapper built directly on the io_uring_setup/enter/register
+ * system calls, so there is no liburing dependency. One instance belongs to
+ * one thread, and that thread must be the one that constructed it
+ */
+class IoUring
+{
+public:
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    //Returns a zeroed submission entry, submitting queued entries first if the queue is full
+    io_uring_sqe *getSubmissionEntry();
+    //Submits queued entries and waits for at least waitCount completions
+    int submit(unsigned waitCount = 0);
+
+    template <typename CompletionHandler>
+    unsigned processCompletions(CompletionHandler &&handler)
+    {
+        unsigned head{*this->m_completionHead};
+        unsigned tail{__atomic_load_n(this->m_completionTail, __ATOMIC_ACQUIRE)};
+        unsigned processed{0};
+        while (head != tail) {
+            handler(this->m_completionEntries[head & *this->m_completionRingMask]);
+            head++;
+            processed++;
+        }
+        __atomic_store_n(this->m_completionHead, head, __ATOMIC_RELEASE);
+        return processed;
+    }
+
+    //Provided buffer ring, consumed by IOSQE_BUFFER_SELECT operations in groupId
+    void setupBufferRing(uint16_t groupId, unsigned bufferCount, unsigned bufferSize);
+    char *buffer(uint16_t bufferId);
+    void recycleBuffer(uint16_t bufferId);
+    unsigned bufferSize() const;
+    uint16_t bufferGroup() const;
+
+private:
+    int m_ringDescriptor;
+    io_uring_params m_parameters;
+    void *m_ringMemory;
+    size_t m_ringMemorySize;
+    io_uring_sqe *m_submissionEntries;
+    size_t m_submissionEntriesSize;
+
+    unsigned *m_submissionHead;
+    unsigned *m_submissionTail;
+    unsigned *m_submissionRingMask;
+    unsigned *m_submissionArray;
+    unsigned m_submissionLocalTail;
+    unsigned m_submissionSubmitted;
+
+    unsigned *m_completionHead;
+    unsigned *m_completionTail;
+    unsigned *m_completionRingMask;
+    io_uring_cqe *m_completionEntries;
+
+    io_uring_buf_ring *m_bufferRing;
+    size_t m_bufferRingSize;
+    std::vector<char> m_bufferStorage;
+    unsigned m_bufferCount;
+    unsigned m_bufferSize;
+    uint16_t m_bufferGroup;
+
+    void release();
+};
+
+} //namespace CppSerialPort
+
+#endif //defined(CPPSERIALPORT_HAS_IO_URING)
+
+#endif //CPPSERIALPORT_IOURING_H
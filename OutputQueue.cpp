@@ -0,0 +1,412 @@
+#include "OutputQueue.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <chrono>
+
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ZeroCopy.h"
+
+namespace CppSerialPort {
+
+const size_t OutputQueue::MAXIMUM_GATHER_COUNT{IOV_MAX};
+
+//The kernel keeps reading a zero copy buffer for retransmits even after the socket is closed, so buffers of sends
+//still unfinished when their queue is cleared are parked this long, by which time the peer has acknowledged or is gone
+static const std::chrono::seconds ZERO_COPY_QUARANTINE{120};
+
+struct ZeroCopyQuarantine
+{
+    std::mutex mutex;
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::vector<PooledBuffer>>> entries;
+};
+
+static void quarantineZeroCopyBuffers(std::vector<PooledBuffer> buffers)
+{
+    //Never destroyed, so queues torn down after main() returns can still park their buffers
+    static auto quarantine = new ZeroCopyQuarantine{};
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> quarantineLock{quarantine->mutex};
+    (void)quarantineLock;
+    while ( (!quarantine->entries.empty()) && ((now - quarantine->entries.front().first) >= ZERO_COPY_QUARANTINE) ) {
+        quarantine->entries.pop_front();
+    }
+    quarantine->entries.emplace_back(now, std::move(buffers));
+}
+
+OutputQueue::File::File(int descriptor) :
+    descriptor{descriptor},
+    pipeDescriptors{-1, -1},
+    pipedBytes{0}
+{
+
+}
+
+OutputQueue::File::~File()
+{
+    ::close(this->descriptor);
+    if (this->pipeDescriptors[0] != -1) {
+        ::close(this->pipeDescriptors[0]);
+        ::close(this->pipeDescriptors[1]);
+    }
+}
+
+OutputQueue::OutputQueue() :
+    m_segments{},
+    m_frontOffset{0},
+    m_size{0},
+    m_bytesSent{0},
+    m_zeroCopyThreshold{0},
+    m_zeroCopyCopied{false},
+    m_zeroCopySequence{0},
+    m_zeroCopySends{}
+{
+
+}
+
+OutputQueue::~OutputQueue()
+{
+    this->clear();
+}
+
+void OutputQueue::appendStatic(const char *data, size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    this->m_segments.push_back(Segment{data, length, false, PooledBuffer{}, nullptr, 0, false});
+    this->m_size += length;
+}
+
+void OutputQueue::appendBorrowed(const char *data, size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    this->m_segments.push_back(Segment{data, length, true, PooledBuffer{}, nullptr, 0, false});
+    this->m_size += length;
+}
+
+void OutputQueue::appendCopy(const char *data, size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    auto storage = BufferPool::acquire(length);
+    memcpy(storage.data(), data, length);
+    this->m_segments.push_back(Segment{storage.data(), length, false, std::move(storage), nullptr, 0, false});
+    this->m_size += length;
+}
+
+void OutputQueue::appendFile(int fileDescriptor, off_t offset, size_t length)
+{
+    std::shared_ptr<File> file{new File{fileDescriptor}};
+    if (length == 0) {
+        return;
+    }
+    this->m_segments.push_back(Segment{nullptr, length, false, PooledBuffer{}, std::move(file), offset, false});
+    this->m_size += length;
+}
+
+void OutputQueue::retain()
+{
+    for (auto it = this->m_segments.begin(); it != this->m_segments.end(); it++) {
+        if (!it->borrowed) {
+            continue;
+        }
+        //Only the unsent part of the front segment is worth keeping
+        size_t offset{(it == this->m_segments.begin()) ? this->m_frontOffset : 0};
+        it->storage = BufferPool::acquire(it->length - offset);
+        memcpy(it->storage.data(), it->data + offset, it->length - offset);
+        it->data = it->storage.data();
+        it->length -= offset;
+        it->borrowed = false;
+        if (it == this->m_segments.begin()) {
+            this->m_frontOffset = 0;
+        }
+    }
+}
+
+void OutputQueue::splice(OutputQueue &other)
+{
+    other.retain();
+    for (auto it = other.m_segments.begin(); it != other.m_segments.end(); it++) {
+        size_t offset{(it == other.m_segments.begin()) ? other.m_frontOffset : 0};
+        if (it->file) {
+            this->m_segments.push_back(Segment{nullptr, it->length - offset, false, PooledBuffer{}, std::move(it->file), it->fileOffset + static_cast<off_t>(offset), false});
+            this->m_size += it->length - offset;
+            continue;
+        }
+        if (!it->storage) {
+            this->appendStatic(it->data + offset, it->length - offset);
+            continue;
+        }
+        //Pooled storage never moves, so the data pointer carries over with it
+        this->m_segments.push_back(Segment{it->data + offset, it->length - offset, false, std::move(it->storage), nullptr, 0, false});
+        this->m_size += it->length - offset;
+    }
+    other.clear();
+}
+
+size_t OutputQueue::gather(iovec *vectors, size_t count) const
+{
+    size_t returnValue{0};
+    for (auto it = this->m_segments.cbegin(); (it != this->m_segments.cend()) && (returnValue < count); it++) {
+        if (it->file) {
+            break;
+        }
+        size_t offset{(it == this->m_segments.cbegin()) ? this->m_frontOffset : 0};
+        vectors[returnValue].iov_base = const_cast<char *>(it->data + offset);
+        vectors[returnValue].iov_len = it->length - offset;
+        returnValue++;
+    }
+    return returnValue;
+}
+
+bool OutputQueue::frontIsFile() const
+{
+    return ( (!this->m_segments.empty()) && (this->m_segments.front().file) );
+}
+
+void OutputQueue::consume(size_t length)
+{
+    if (length > this->m_size) {
+        length = this->m_size;
+    }
+    this->m_size -= length;
+    this->m_bytesSent += length;
+    while (length > 0) {
+        auto &front = this->m_segments.front();
+        auto remaining = front.length - this->m_frontOffset;
+        if (length < remaining) {
+            this->m_frontOffset += length;
+            return;
+        }
+        length -= remaining;
+        //Sends reading from the storage may still be in flight, and the newest one finishes last
+        if ( (front.zeroCopied) && (front.storage) && (!this->m_zeroCopySends.empty()) ) {
+            this->m_zeroCopySends.back().buffers.push_back(std::move(front.storage));
+        }
+        this->m_segments.pop_front();
+        this->m_frontOffset = 0;
+    }
+}
+
+OutputQueue::FlushResult OutputQueue::flush(int socketDescriptor)
+{
+    iovec vectors[MAXIMUM_GATHER_COUNT];
+    auto allowZeroCopy = true;
+    while (!this->m_segments.empty()) {
+        if (this->m_segments.front().file) {
+            auto flushResult = this->flushFile(socketDescriptor);
+            if (flushResult != FlushResult::Complete) {
+                return flushResult;
+            }
+            continue;
+        }
+        msghdr message{};
+        message.msg_iov = vectors;
+        message.msg_iovlen = this->gather(vectors, MAXIMUM_GATHER_COUNT);
+        auto zeroCopy = ( (allowZeroCopy) && (this->shouldZeroCopy(message.msg_iovlen)) );
+        auto sendResult = sendmsg(socketDescriptor, &message, MSG_NOSIGNAL | (zeroCopy ? ZeroCopy::SEND_FLAG : 0));
+        if (sendResult == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                return FlushResult::WouldBlock;
+            } else if (errno == EINTR) {
+                continue;
+            } else if ( (zeroCopy) && (errno == ENOBUFS) ) {
+                //Too many unfinished zero copy sends for the socket's option memory, copy until the next flush
+                allowZeroCopy = false;
+                continue;
+            }
+            return FlushResult::Error;
+        }
+        if (zeroCopy) {
+            this->beginZeroCopySend(static_cast<size_t>(sendResult));
+        }
+        this->consume(static_cast<size_t>(sendResult));
+    }
+    return FlushResult::Complete;
+}
+
+OutputQueue::FlushResult OutputQueue::flushFile(int socketDescriptor)
+{
+    //Sends the front file range, Complete means it is fully out
+    auto &front = this->m_segments.front();
+    auto &file = *front.file;
+    while (front.length > this->m_frontOffset) {
+        if (file.pipeDescriptors[0] != -1) {
+            return this->spliceFile(socketDescriptor);
+        }
+        off_t fileOffset{front.fileOffset + static_cast<off_t>(this->m_frontOffset)};
+        auto sendResult = sendfile(socketDescriptor, file.descriptor, &fileOffset, front.length - this->m_frontOffset);
+        if (sendResult == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                return FlushResult::WouldBlock;
+            } else if (errno == EINTR) {
+                continue;
+            } else if ( (errno == EINVAL) || (errno == ENOSYS) ) {
+                //This file cannot be sent directly, so move it through a pipe from now on
+                if (pipe2(file.pipeDescriptors, O_CLOEXEC | O_NONBLOCK) == -1) {
+                    return FlushResult::Error;
+                }
+                continue;
+            }
+            return FlushResult::Error;
+        } else if (sendResult == 0) {
+            //The file is shorter than the range that was queued
+            errno = EIO;
+            return FlushResult::Error;
+        }
+        //The front range may be fully sent and popped here, so do not touch it afterwards
+        auto remaining = front.length - this->m_frontOffset;
+        this->consume(static_cast<size_t>(sendResult));
+        if (static_cast<size_t>(sendResult) == remaining) {
+            return FlushResult::Complete;
+        }
+    }
+    return FlushResult::Complete;
+}
+
+OutputQueue::FlushResult OutputQueue::spliceFile(int socketDescriptor)
+{
+    auto &front = this->m_segments.front();
+    auto &file = *front.file;
+    while (true) {
+        auto remaining = front.length - this->m_frontOffset;
+        //Top up the pipe with whatever of the range is not in it yet
+        if (remaining > file.pipedBytes) {
+            loff_t fileOffset{front.fileOffset + static_cast<loff_t>(this->m_frontOffset + file.pipedBytes)};
+            auto spliceResult = ::splice(file.descriptor, &fileOffset, file.pipeDescriptors[1], nullptr, remaining - file.pipedBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (spliceResult == 0) {
+                errno = EIO;
+                return FlushResult::Error;
+            } else if (spliceResult > 0) {
+                file.pipedBytes += static_cast<size_t>(spliceResult);
+            } else if ( (errno != EAGAIN) && (errno != EINTR) ) {
+                return FlushResult::Error;
+            }
+        }
+        auto spliceResult = ::splice(file.pipeDescriptors[0], nullptr, socketDescriptor, nullptr, file.pipedBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (spliceResult == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                return FlushResult::WouldBlock;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            return FlushResult::Error;
+        }
+        file.pipedBytes -= static_cast<size_t>(spliceResult);
+        this->consume(static_cast<size_t>(spliceResult));
+        if (static_cast<size_t>(spliceResult) == remaining) {
+            return FlushResult::Complete;
+        }
+    }
+}
+
+size_t OutputQueue::size() const
+{
+    return this->m_size;
+}
+
+bool OutputQueue::empty() const
+{
+    return this->m_segments.empty();
+}
+
+uint64_t OutputQueue::bytesSent() const
+{
+    return this->m_bytesSent;
+}
+
+void OutputQueue::clear()
+{
+    std::vector<PooledBuffer> referenced{};
+    if (!this->m_zeroCopySends.empty()) {
+        for (auto &it : this->m_segments) {
+            if ( (it.zeroCopied) && (it.storage) ) {
+                referenced.push_back(std::move(it.storage));
+            }
+        }
+        for (auto &it : this->m_zeroCopySends) {
+            std::move(it.buffers.begin(), it.buffers.end(), std::back_inserter(referenced));
+        }
+        this->m_zeroCopySends.clear();
+    }
+    if (!referenced.empty()) {
+        quarantineZeroCopyBuffers(std::move(referenced));
+    }
+    this->m_segments.clear();
+    this->m_frontOffset = 0;
+    this->m_size = 0;
+}
+
+void OutputQueue::setZeroCopyThreshold(size_t threshold)
+{
+    this->m_zeroCopyThreshold = threshold;
+}
+
+size_t OutputQueue::zeroCopyThreshold() const
+{
+    return this->m_zeroCopyThreshold;
+}
+
+size_t OutputQueue::zeroCopyPending() const
+{
+    return this->m_zeroCopySends.size();
+}
+
+bool OutputQueue::shouldZeroCopy(size_t count) const
+{
+    if ( (this->m_zeroCopyThreshold == 0) || (this->m_zeroCopyCopied) ) {
+        return false;
+    }
+    //Borrowed ranges are reused by their owner once retain() returns, while the kernel may still be reading them
+    size_t bytes{0};
+    auto it = this->m_segments.cbegin();
+    for (size_t i = 0; i < count; i++, it++) {
+        if (it->borrowed) {
+            return false;
+        }
+        bytes += it->length - ((i == 0) ? this->m_frontOffset : 0);
+    }
+    return (bytes >= this->m_zeroCopyThreshold);
+}
+
+void OutputQueue::beginZeroCopySend(size_t length)
+{
+    this->m_zeroCopySends.push_back(ZeroCopySend{this->m_zeroCopySequence++, false, std::vector<PooledBuffer>{}});
+    size_t covered{0};
+    for (auto it = this->m_segments.begin(); (it != this->m_segments.end()) && (covered < length); it++) {
+        it->zeroCopied = true;
+        covered += it->length - ((it == this->m_segments.begin()) ? this->m_frontOffset : 0);
+    }
+}
+
+bool OutputQueue::reapZeroCopy(int socketDescriptor)
+{
+    std::vector<ZeroCopy::Completion> completions{};
+    if (!ZeroCopy::readCompletions(socketDescriptor, completions)) {
+        return false;
+    }
+    for (const auto &completion : completions) {
+        this->m_zeroCopyCopied |= completion.copied;
+        for (auto &it : this->m_zeroCopySends) {
+            it.completed |= ZeroCopy::covers(completion, it.sequence);
+        }
+    }
+    //In order, so a buffer is only released once every send that could have read it has completed
+    while ( (!this->m_zeroCopySends.empty()) && (this->m_zeroCopySends.front().completed) ) {
+        this->m_zeroCopySends.pop_front();
+    }
+    return true;
+}
+
+} //namespace CppSerialPort
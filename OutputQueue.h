@@ -0,0 +1,133 @@
+#ifndef CPPSERIALPORT_OUTPUTQUEUE_H
+#define CPPSERIALPORT_OUTPUTQUEUE_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "BufferPool.h"
+
+namespace CppSerialPort {
+
+/*
+ * Queue of outgoing byte ranges sent with one gathered sendmsg() call. Ranges
+ * may point at static data, borrow a caller's buffer (for example a slice of the
+ * receive buffer), or own a copy in a pooled buffer. Borrowed ranges are only
+ * copied by retain(), and only if they could not be sent before the caller
+ * reuses its buffer.
+ * File ranges never pass through user space, flush() hands them to the socket
+ * with sendfile(), or splice() through a pipe where sendfile() is refused.
+ * Neither call takes MSG_NOSIGNAL, so SIGPIPE must be ignored or handled.
+ * Large sends of copied or static data can go out with MSG_ZEROCOPY, whose
+ * buffers are held until the kernel reports it is done with them
+ */
+class OutputQueue
+{
+public:
+    enum class FlushResult {
+        Complete,
+        WouldBlock,
+        Error
+    };
+
+    OutputQueue();
+    ~OutputQueue();
+    OutputQueue(const OutputQueue &) = delete;
+    OutputQueue &operator=(const OutputQueue &) = delete;
+
+    //Data must outlive the queue
+    void appendStatic(const char *data, size_t length);
+    //Data must stay valid until the next call to retain()
+    void appendBorrowed(const char *data, size_t length);
+    void appendCopy(const char *data, size_t length);
+    //Takes ownership of fileDescriptor, which is closed once the range is sent or the queue is cleared
+    void appendFile(int fileDescriptor, off_t offset, size_t length);
+    void retain();
+    //Moves everything unsent in other to the back of this queue, leaving other empty
+    void splice(OutputQueue &other);
+
+    //Fills at most count iovecs with the queued data, starting at the first unsent byte
+    //and stopping at the first file range, which cannot be gathered
+    size_t gather(iovec *vectors, size_t count) const;
+    bool frontIsFile() const;
+    void consume(size_t length);
+    FlushResult flush(int socketDescriptor);
+
+    size_t size() const;
+    bool empty() const;
+    //Total bytes consumed since construction, so callers can tell whether a send made progress
+    uint64_t bytesSent() const;
+    void clear();
+
+    //Sends of at least threshold bytes with no borrowed ranges use MSG_ZEROCOPY, 0 always copies.
+    //SO_ZEROCOPY must already be set on the socket (see ZeroCopy::enable())
+    void setZeroCopyThreshold(size_t threshold);
+    size_t zeroCopyThreshold() const;
+    //Zero copy sends the kernel has not reported complete yet
+    size_t zeroCopyPending() const;
+    //Reads completions off the socket's error queue and releases the buffers that are no longer referenced
+    bool reapZeroCopy(int socketDescriptor);
+
+    static const size_t MAXIMUM_GATHER_COUNT;
+
+private:
+    struct File
+    {
+        explicit File(int descriptor);
+        ~File();
+        File(const File &) = delete;
+        File &operator=(const File &) = delete;
+
+        int descriptor;
+        //Only created once sendfile() is refused, holds bytes read from the file but not yet sent
+        int pipeDescriptors[2];
+        size_t pipedBytes;
+    };
+
+    struct Segment
+    {
+        const char *data;
+        size_t length;
+        bool borrowed;
+        PooledBuffer storage;
+        std::shared_ptr<File> file;
+        off_t fileOffset;
+        //Handed to a zero copy send, so the storage outlives the segment until that send completes
+        bool zeroCopied;
+    };
+
+    struct ZeroCopySend
+    {
+        uint32_t sequence;
+        bool completed;
+        //Storage of segments consumed while this was the newest zero copy send,
+        //released once it and every send before it has completed
+        std::vector<PooledBuffer> buffers;
+    };
+
+    //Segments are only added at the back and removed at the front, so a deque never moves them
+    std::deque<Segment> m_segments;
+    size_t m_frontOffset;
+    size_t m_size;
+    uint64_t m_bytesSent;
+    size_t m_zeroCopyThreshold;
+    //Set once the kernel reports it copied a zero copy send anyway, pinning pages only costs more from then on
+    bool m_zeroCopyCopied;
+    uint32_t m_zeroCopySequence;
+    std::deque<ZeroCopySend> m_zeroCopySends;
+
+    bool shouldZeroCopy(size_t count) const;
+    void beginZeroCopySend(size_t length);
+    FlushResult flushFile(int socketDescriptor);
+    FlushResult spliceFile(int socketDescriptor);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_OUTPUTQUEUE_H
@@ -0,0 +1,89 @@
+#include "PeerAddress.h"
+
+#include <cstring>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace CppSerialPort {
+
+PeerAddress::PeerAddress() :
+    m_address{},
+    m_addressLength{0},
+    m_port{0},
+    m_hostLength{0},
+    m_formattedAddress{"[unknown]"}
+{
+
+}
+
+PeerAddress::PeerAddress(const sockaddr *address, socklen_t addressLength) :
+    PeerAddress{}
+{
+    if ( (address == nullptr) || (addressLength == 0) ) {
+        return;
+    }
+    if (addressLength > sizeof(this->m_address)) {
+        addressLength = sizeof(this->m_address);
+    }
+    memcpy(&this->m_address, address, addressLength);
+    this->m_addressLength = addressLength;
+
+    char host[INET6_ADDRSTRLEN];
+    memset(host, '\0', INET6_ADDRSTRLEN);
+    if (this->m_address.ss_family == AF_INET) {
+        auto ipv4Address = reinterpret_cast<const sockaddr_in *>(&this->m_address);
+        inet_ntop(AF_INET, &ipv4Address->sin_addr, host, sizeof(host));
+        this->m_port = ntohs(ipv4Address->sin_port);
+    } else if (this->m_address.ss_family == AF_INET6) {
+        auto ipv6Address = reinterpret_cast<const sockaddr_in6 *>(&this->m_address);
+        inet_ntop(AF_INET6, &ipv6Address->sin6_addr, host, sizeof(host));
+        this->m_port = ntohs(ipv6Address->sin6_port);
+    } else {
+        return;
+    }
+    this->m_hostLength = strlen(host);
+    this->m_formattedAddress = '[' + std::string{host, this->m_hostLength} + ':' + std::to_string(this->m_port) + ']';
+}
+
+PeerAddress PeerAddress::fromDescriptor(int socketDescriptor)
+{
+    sockaddr_storage address{};
+    socklen_t addressLength{sizeof(address)};
+    if (getpeername(socketDescriptor, reinterpret_cast<sockaddr *>(&address), &addressLength) == -1) {
+        return PeerAddress{};
+    }
+    return PeerAddress{reinterpret_cast<sockaddr *>(&address), addressLength};
+}
+
+const sockaddr *PeerAddress::address() const
+{
+    return reinterpret_cast<const sockaddr *>(&this->m_address);
+}
+
+socklen_t PeerAddress::addressLength() const
+{
+    return this->m_addressLength;
+}
+
+int PeerAddress::family() const
+{
+    return this->m_address.ss_family;
+}
+
+std::string PeerAddress::host() const
+{
+    return (this->m_hostLength == 0) ? std::string{} : this->m_formattedAddress.substr(1, this->m_hostLength);
+}
+
+uint16_t PeerAddress::port() const
+{
+    return this->m_port;
+}
+
+const std::string &PeerAddress::toString() const
+{
+    return this->m_formattedAddress;
+}
+
+} //namespace CppSerialPort
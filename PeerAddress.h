@@ -0,0 +1,42 @@
+#ifndef CPPSERIALPORT_PEERADDRESS_H
+#define CPPSERIALPORT_PEERADDRESS_H
+
+#include <string>
+#include <cstdint>
+
+#include <sys/socket.h>
+
+namespace CppSerialPort {
+
+/*
+ * Identity of the remote end of a connection. The address is kept in a full
+ * sockaddr_storage (so IPv6 is never truncated) and formatted exactly once,
+ * when the connection is accepted, so logging and metrics never have to
+ * call getnameinfo()/inet_ntop() on the data path
+ */
+class PeerAddress
+{
+public:
+    PeerAddress();
+    PeerAddress(const sockaddr *address, socklen_t addressLength);
+
+    static PeerAddress fromDescriptor(int socketDescriptor);
+
+    const sockaddr *address() const;
+    socklen_t addressLength() const;
+    int family() const;
+    std::string host() const;
+    uint16_t port() const;
+    const std::string &toString() const;
+
+private:
+    sockaddr_storage m_address;
+    socklen_t m_addressLength;
+    uint16_t m_port;
+    size_t m_hostLength;
+    std::string m_formattedAddress;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_PEERADDRESS_H
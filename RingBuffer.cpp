@@ -0,0 +1,138 @@
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace CppSerialPort {
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t returnValue{1};
+    while (returnValue < value) {
+        returnValue <<= 1;
+    }
+    return returnValue;
+}
+
+RingBuffer::RingBuffer(size_t capacity) :
+    m_storage{new char[roundUpToPowerOfTwo(capacity)]},
+    m_capacity{roundUpToPowerOfTwo(capacity)},
+    m_readPosition{0},
+    m_writePosition{0}
+{
+
+}
+
+size_t RingBuffer::mask() const
+{
+    return this->m_capacity - 1;
+}
+
+size_t RingBuffer::size() const
+{
+    return this->m_writePosition - this->m_readPosition;
+}
+
+bool RingBuffer::empty() const
+{
+    return (this->m_writePosition == this->m_readPosition);
+}
+
+size_t RingBuffer::capacity() const
+{
+    return this->m_capacity;
+}
+
+size_t RingBuffer::space() const
+{
+    return this->m_capacity - this->size();
+}
+
+const char *RingBuffer::readable(size_t *length) const
+{
+    auto offset = (this->m_readPosition & this->mask());
+    *length = std::min(this->size(), this->m_capacity - offset);
+    return this->m_storage.get() + offset;
+}
+
+void RingBuffer::consume(size_t length)
+{
+    this->m_readPosition += std::min(length, this->size());
+}
+
+char *RingBuffer::writable(size_t *length)
+{
+    //Restarting an empty buffer at the beginning gives the caller all of it in one run
+    if (this->empty()) {
+        this->clear();
+    }
+    auto offset = (this->m_writePosition & this->mask());
+    *length = std::min(this->space(), this->m_capacity - offset);
+    return this->m_storage.get() + offset;
+}
+
+void RingBuffer::commit(size_t length)
+{
+    this->m_writePosition += std::min(length, this->space());
+}
+
+char RingBuffer::front() const
+{
+    return this->m_storage[this->m_readPosition & this->mask()];
+}
+
+char RingBuffer::pop()
+{
+    return this->m_storage[this->m_readPosition++ & this->mask()];
+}
+
+size_t RingBuffer::read(char *buffer, size_t length)
+{
+    size_t copied{0};
+    //At most two runs, one either side of the wrap
+    while ( (copied < length) && (!this->empty()) ) {
+        size_t available{0};
+        auto data = this->readable(&available);
+        auto count = std::min(available, length - copied);
+        memcpy(buffer + copied, data, count);
+        this->consume(count);
+        copied += count;
+    }
+    return copied;
+}
+
+void RingBuffer::putBack(char c)
+{
+    this->putBack(&c, 1);
+}
+
+void RingBuffer::putBack(const char *data, size_t length)
+{
+    if (length > this->space()) {
+        this->grow(this->size() + length);
+    }
+    this->m_readPosition -= length;
+    auto offset = (this->m_readPosition & this->mask());
+    auto firstRun = std::min(length, this->m_capacity - offset);
+    memcpy(this->m_storage.get() + offset, data, firstRun);
+    memcpy(this->m_storage.get(), data + firstRun, length - firstRun);
+}
+
+void RingBuffer::clear()
+{
+    this->m_readPosition = 0;
+    this->m_writePosition = 0;
+}
+
+void RingBuffer::grow(size_t minimumCapacity)
+{
+    auto capacity = roundUpToPowerOfTwo(minimumCapacity);
+    std::unique_ptr<char[]> storage{new char[capacity]};
+    auto length = this->read(storage.get(), this->size());
+    this->m_storage = std::move(storage);
+    this->m_capacity = capacity;
+    this->m_readPosition = 0;
+    this->m_writePosition = length;
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,56 @@
+#ifndef CPPSERIALPORT_RINGBUFFER_H
+#define CPPSERIALPORT_RINGBUFFER_H
+
+#include <memory>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+/*
+ * Byte queue over a power of two sized buffer, so positions wrap with a mask
+ * and taking bytes off the front, or handing them back, is O(1). The read and
+ * write cursors run freely and only their difference counts, so a full buffer
+ * needs no spare slot. readable() and writable() are contiguous runs that stop
+ * where the storage wraps, a caller after everything makes a second pass.
+ * Appending never grows the buffer, but putBack() does when it is full, so
+ * bytes handed back are never lost
+ */
+class RingBuffer
+{
+public:
+    //Rounded up to a power of two
+    explicit RingBuffer(size_t capacity);
+
+    size_t size() const;
+    bool empty() const;
+    size_t capacity() const;
+    size_t space() const;
+
+    //Unread bytes at the front, up to where the storage wraps
+    const char *readable(size_t *length) const;
+    void consume(size_t length);
+    //Free space after the unread bytes, up to where the storage wraps. Fill it, then commit()
+    char *writable(size_t *length);
+    void commit(size_t length);
+
+    char front() const;
+    char pop();
+    //Copies out and consumes up to length bytes, returns how many
+    size_t read(char *buffer, size_t length);
+    void putBack(char c);
+    void putBack(const char *data, size_t length);
+    void clear();
+
+private:
+    std::unique_ptr<char[]> m_storage;
+    size_t m_capacity;
+    size_t m_readPosition;
+    size_t m_writePosition;
+
+    size_t mask() const;
+    void grow(size_t minimumCapacity);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_RINGBUFFER_H
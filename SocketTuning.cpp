@@ -0,0 +1,185 @@
+#include "SocketTuning.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#if !defined(SO_BUSY_POLL)
+#    define SO_BUSY_POLL 46
+#endif //!defined(SO_BUSY_POLL)
+#if !defined(TCP_NOTSENT_LOWAT)
+#    define TCP_NOTSENT_LOWAT 25
+#endif //!defined(TCP_NOTSENT_LOWAT)
+
+namespace CppSerialPort {
+
+const int SocketTuning::LOW_LATENCY_BUFFER_SIZE{64 * 1024};
+const int SocketTuning::LOW_LATENCY_BUSY_POLL_MICROSECONDS{50};
+const int SocketTuning::BULK_BUFFER_SIZE{4 * 1024 * 1024};
+const int SocketTuning::BULK_NOT_SENT_LOW_WATER_MARK{128 * 1024};
+
+SocketTuning::SocketTuning() :
+    m_profile{Profile::Default},
+    m_noDelay{-1},
+    m_quickAck{-1},
+    m_busyPollMicroseconds{-1},
+    m_sendBufferSize{-1},
+    m_receiveBufferSize{-1},
+    m_notSentLowWaterMark{-1}
+{
+
+}
+
+SocketTuning::SocketTuning(Profile profile) :
+    SocketTuning{}
+{
+    this->m_profile = profile;
+    if (profile == Profile::LowLatency) {
+        this->m_noDelay = 1;
+        this->m_quickAck = 1;
+        this->m_busyPollMicroseconds = LOW_LATENCY_BUSY_POLL_MICROSECONDS;
+        this->m_sendBufferSize = LOW_LATENCY_BUFFER_SIZE;
+        this->m_receiveBufferSize = LOW_LATENCY_BUFFER_SIZE;
+    } else if (profile == Profile::Bulk) {
+        //Nagle stays on so autocorking can merge small writes into full segments
+        this->m_noDelay = 0;
+        this->m_sendBufferSize = BULK_BUFFER_SIZE;
+        this->m_receiveBufferSize = BULK_BUFFER_SIZE;
+        this->m_notSentLowWaterMark = BULK_NOT_SENT_LOW_WATER_MARK;
+    }
+}
+
+SocketTuning SocketTuning::fromDescriptor(int socketDescriptor)
+{
+    auto read = [socketDescriptor](int level, int option) {
+        int value{-1};
+        socklen_t valueLength{sizeof(value)};
+        if (getsockopt(socketDescriptor, level, option, &value, &valueLength) == -1) {
+            return -1;
+        }
+        return value;
+    };
+    SocketTuning returnValue{};
+    returnValue.m_noDelay = read(IPPROTO_TCP, TCP_NODELAY);
+    returnValue.m_quickAck = read(IPPROTO_TCP, TCP_QUICKACK);
+    returnValue.m_busyPollMicroseconds = read(SOL_SOCKET, SO_BUSY_POLL);
+    returnValue.m_sendBufferSize = read(SOL_SOCKET, SO_SNDBUF);
+    returnValue.m_receiveBufferSize = read(SOL_SOCKET, SO_RCVBUF);
+    returnValue.m_notSentLowWaterMark = read(IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+    return returnValue;
+}
+
+SocketTuning::Profile SocketTuning::parseProfile(const std::string &name)
+{
+    if (name == "default") {
+        return Profile::Default;
+    } else if (name == "latency") {
+        return Profile::LowLatency;
+    } else if (name == "bulk") {
+        return Profile::Bulk;
+    }
+    throw std::runtime_error("CppSerialPort::SocketTuning::parseProfile(const std::string &): unknown profile \"" + name + "\" (expected default, latency or bulk)");
+}
+
+std::string SocketTuning::profileName(Profile profile)
+{
+    switch (profile) {
+        case Profile::LowLatency:
+            return "latency";
+        case Profile::Bulk:
+            return "bulk";
+        default:
+            return "default";
+    }
+}
+
+std::vector<std::string> SocketTuning::apply(int socketDescriptor) const
+{
+    std::vector<std::string> failures{};
+    auto set = [socketDescriptor, &failures](int level, int option, const char *optionName, int value) {
+        if ( (value == -1) || (setsockopt(socketDescriptor, level, option, &value, sizeof(value)) != -1) ) {
+            return;
+        }
+        failures.push_back(std::string{"setsockopt(int, int, int, const void *, socklen_t) "} + optionName + ": error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    };
+    //Buffer sizes fix the window scale offered in the handshake, so they only fully apply before connect() or listen()
+    set(SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF", this->m_sendBufferSize);
+    set(SOL_SOCKET, SO_RCVBUF, "SO_RCVBUF", this->m_receiveBufferSize);
+    set(SOL_SOCKET, SO_BUSY_POLL, "SO_BUSY_POLL", this->m_busyPollMicroseconds);
+    set(IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY", this->m_noDelay);
+    set(IPPROTO_TCP, TCP_NOTSENT_LOWAT, "TCP_NOTSENT_LOWAT", this->m_notSentLowWaterMark);
+    set(IPPROTO_TCP, TCP_QUICKACK, "TCP_QUICKACK", this->m_quickAck);
+    return failures;
+}
+
+std::vector<std::string> SocketTuning::applyToAccepted(int socketDescriptor) const
+{
+    //Quick ack mode is connection state, not an option the listener passes on, and the kernel may leave it again later
+    std::vector<std::string> failures{};
+    if ( (this->m_quickAck != -1) && (setsockopt(socketDescriptor, IPPROTO_TCP, TCP_QUICKACK, &this->m_quickAck, sizeof(this->m_quickAck)) == -1) ) {
+        failures.push_back("setsockopt(int, int, int, const void *, socklen_t) TCP_QUICKACK: error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    return failures;
+}
+
+SocketTuning::Profile SocketTuning::profile() const
+{
+    return this->m_profile;
+}
+
+int SocketTuning::noDelay() const
+{
+    return this->m_noDelay;
+}
+
+int SocketTuning::quickAck() const
+{
+    return this->m_quickAck;
+}
+
+int SocketTuning::busyPollMicroseconds() const
+{
+    return this->m_busyPollMicroseconds;
+}
+
+int SocketTuning::sendBufferSize() const
+{
+    return this->m_sendBufferSize;
+}
+
+int SocketTuning::receiveBufferSize() const
+{
+    return this->m_receiveBufferSize;
+}
+
+int SocketTuning::notSentLowWaterMark() const
+{
+    return this->m_notSentLowWaterMark;
+}
+
+std::string SocketTuning::toString() const
+{
+    auto format = [](int value) {
+        return ( (value == -1) ? std::string{"default"} : std::to_string(value) );
+    };
+    //Autocorking is a system wide setting, so it is reported rather than applied
+    std::string autocorking{"unknown"};
+    std::ifstream autocorkingFile{"/proc/sys/net/ipv4/tcp_autocorking"};
+    if (autocorkingFile.is_open()) {
+        std::getline(autocorkingFile, autocorking);
+    }
+    return "TCP_NODELAY=" + format(this->m_noDelay) +
+           ", TCP_QUICKACK=" + format(this->m_quickAck) +
+           ", SO_BUSY_POLL=" + format(this->m_busyPollMicroseconds) +
+           ", SO_SNDBUF=" + format(this->m_sendBufferSize) +
+           ", SO_RCVBUF=" + format(this->m_receiveBufferSize) +
+           ", TCP_NOTSENT_LOWAT=" + format(this->m_notSentLowWaterMark) +
+           ", tcp_autocorking=" + autocorking;
+}
+
+} //namespace CppSerialPort
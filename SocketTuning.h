@@ -0,0 +1,68 @@
+#ifndef CPPSERIALPORT_SOCKETTUNING_H
+#define CPPSERIALPORT_SOCKETTUNING_H
+
+#include <string>
+#include <vector>
+
+namespace CppSerialPort {
+
+/*
+ * A coherent set of TCP transport options, applied to a client socket before
+ * connect() or to a listener before listen() (accepted sockets inherit them
+ * from their listener). Any value left at -1 is not touched, so the Default
+ * profile keeps the kernel's own autotuning. fromDescriptor() reads back what
+ * the kernel actually applied, which may be capped (net.core.wmem_max and
+ * rmem_max) or doubled (SO_SNDBUF/SO_RCVBUF include bookkeeping overhead)
+ */
+class SocketTuning
+{
+public:
+    enum class Profile {
+        Default,
+        //Nagle off, quick acks, busy polling and small buffers, so nothing queues behind a request
+        LowLatency,
+        //Nagle and kernel autocorking left on, large buffers, and a send queue kept just deep enough to stay busy
+        Bulk
+    };
+
+    SocketTuning();
+    explicit SocketTuning(Profile profile);
+
+    static SocketTuning fromDescriptor(int socketDescriptor);
+    //Accepts default, latency or bulk, and throws on anything else
+    static Profile parseProfile(const std::string &name);
+    static std::string profileName(Profile profile);
+
+    //Every option is best effort (SO_BUSY_POLL above net.core.busy_read needs CAP_NET_ADMIN),
+    //so failures are returned, one message per option, rather than thrown
+    std::vector<std::string> apply(int socketDescriptor) const;
+    //The part an accepted socket does not inherit from its listener
+    std::vector<std::string> applyToAccepted(int socketDescriptor) const;
+
+    Profile profile() const;
+    int noDelay() const;
+    int quickAck() const;
+    int busyPollMicroseconds() const;
+    int sendBufferSize() const;
+    int receiveBufferSize() const;
+    int notSentLowWaterMark() const;
+    std::string toString() const;
+
+    static const int LOW_LATENCY_BUFFER_SIZE;
+    static const int LOW_LATENCY_BUSY_POLL_MICROSECONDS;
+    static const int BULK_BUFFER_SIZE;
+    static const int BULK_NOT_SENT_LOW_WATER_MARK;
+
+private:
+    Profile m_profile;
+    int m_noDelay;
+    int m_quickAck;
+    int m_busyPollMicroseconds;
+    int m_sendBufferSize;
+    int m_receiveBufferSize;
+    int m_notSentLowWaterMark;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_SOCKETTUNING_H
@@ -4,23 +4,36 @@
 #    include "Ws2tcpip.h"
 #else
 #    include <unistd.h>
+#    include <fcntl.h>
+#    include <poll.h>
+#    include "ZeroCopy.h"
 #    define INVALID_SOCKET -1
 #endif //defined(_WIN32)
 
+#include <algorithm>
 #include <cstring>
 #include <climits>
 #include <iostream>
+#include <vector>
 
 namespace CppSerialPort {
 
 #define MINIMUM_PORT_NUMBER 1024
-#define TCP_CLIENT_BUFFER_MAX 8192
+#define TCP_CLIENT_SPLICE_MAX (1024 * 1024)
+
+const size_t TcpClient::DEFAULT_RECEIVE_BUFFER_SIZE{8192};
 
 TcpClient::TcpClient(const std::string &hostName, uint16_t portNumber) :
     m_socketDescriptor{INVALID_SOCKET},
     m_hostName{hostName},
     m_portNumber{portNumber},
-    m_readBuffer{""}
+    m_readBuffer{DEFAULT_RECEIVE_BUFFER_SIZE},
+    m_socketTuning{},
+    m_connectTimeout{0},
+    m_zeroCopyThreshold{0},
+    m_zeroCopyEnabled{false},
+    m_zeroCopyPending{0},
+    m_connectionLost{false}
 {
     #if defined(_WIN32)
 	WSADATA wsaData{};
@@ -69,19 +82,21 @@ std::string TcpClient::getErrorString(int errorCode)
 	(void)conversionResult;
 	//wcstombs(errorString, wideErrorString, PATH_MAX);
 	LocalFree(wideErrorString);
+	return stripLineEndings(errorString);
 #else
+    //The GNU strerror_r() may return a static string and leave errorString untouched
     auto strerrorCode = strerror_r(errorCode, errorString, PATH_MAX);
     if (strerrorCode == nullptr) {
         std::cerr << "strerror_r(int, char *, int): error occurred" << std::endl;
         return "";
     }
+	return stripLineEndings(strerrorCode);
 #endif //defined(_WIN32)
-	return stripLineEndings(errorString);
 }
 
 TcpClient::~TcpClient()
 {
-    if (this->isConnected()) {
+    if (this->m_socketDescriptor != INVALID_SOCKET) {
         this->disconnect();
     }
 }
@@ -101,6 +116,10 @@ void TcpClient::connect()
     if (this->isConnected()) {
         throw std::runtime_error("CppSerialPort::TcpClient::connect(): Cannot connect to new host when already connected (call disconnect() first)");
     }
+    //A connection the peer dropped still holds its descriptor until now
+    if (this->m_socketDescriptor != INVALID_SOCKET) {
+        this->disconnect();
+    }
     addrinfo *addressInfo{nullptr};
     addrinfo hints{};
     memset(reinterpret_cast<void *>(&hints), 0, sizeof(addrinfo));
@@ -135,14 +154,51 @@ void TcpClient::connect()
 		auto errorCode = getLastError();
         throw std::runtime_error("CppSerialPort::TcpClient::connect(): setsockopt(int, int, int, const void *, socklen_t): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
     }
-
+#if !defined(_WIN32)
+    //Best effort, effectiveSocketTuning() shows what the kernel accepted
+    (void)this->m_socketTuning.apply(socketDescriptor);
+    //Kernels without SO_ZEROCOPY just keep copying
+    this->m_zeroCopyEnabled = ( (this->m_zeroCopyThreshold != 0) && (ZeroCopy::enable(socketDescriptor)) );
+    this->m_zeroCopyPending = 0;
+#endif //!defined(_WIN32)
+
+    //Connected without blocking, so the handshake is waited out with poll() against the connect timeout
+    auto connectDeadline = ( (this->m_connectTimeout == 0) ? Deadline::never() : Deadline{std::chrono::milliseconds{this->m_connectTimeout}} );
+#if defined(_WIN32)
+    u_long nonBlocking{1};
+    (void)ioctlsocket(this->m_socketDescriptor, FIONBIO, &nonBlocking);
+#else
+    auto descriptorFlags = fcntl(this->m_socketDescriptor, F_GETFL, 0);
+    (void)fcntl(this->m_socketDescriptor, F_SETFL, descriptorFlags | O_NONBLOCK);
+#endif //defined(_WIN32)
     auto connectResult = ::connect(this->m_socketDescriptor, addressInfo->ai_addr, addressInfo->ai_addrlen);
+    freeaddrinfo(addressInfo);
     if (connectResult == -1) {
-        freeaddrinfo(addressInfo);
 		auto errorCode = getLastError();
-        throw std::runtime_error("CppSerialPort::TcpClient::connect(): connect(int, const sockaddr *addr, socklen_t): error code " + toStdString(errorCode) +  " (" + getErrorString(errorCode) + ')');
+#if defined(_WIN32)
+        auto inProgress = (errorCode == WSAEWOULDBLOCK);
+#else
+        //An interrupted connect() carries on in the background just the same
+        auto inProgress = ( (errorCode == EINPROGRESS) || (errorCode == EINTR) );
+#endif //defined(_WIN32)
+        if (inProgress) {
+            errorCode = ETIMEDOUT;
+            if (this->waitForEvents(POLLOUT, connectDeadline)) {
+                socklen_t errorCodeLength{sizeof(errorCode)};
+                (void)getsockopt(this->m_socketDescriptor, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&errorCode), &errorCodeLength);
+            }
+        }
+        if (errorCode != 0) {
+            this->disconnect();
+            throw std::runtime_error("CppSerialPort::TcpClient::connect(): connect(int, const sockaddr *addr, socklen_t): error code " + toStdString(errorCode) +  " (" + getErrorString(errorCode) + ')');
+        }
     }
-    freeaddrinfo(addressInfo);
+#if defined(_WIN32)
+    nonBlocking = 0;
+    (void)ioctlsocket(this->m_socketDescriptor, FIONBIO, &nonBlocking);
+#else
+    (void)fcntl(this->m_socketDescriptor, F_SETFL, descriptorFlags);
+#endif //defined(_WIN32)
     this->m_readBuffer.clear();
 
     auto tv = toTimeVal(static_cast<uint32_t>(this->readTimeout()));
@@ -168,57 +224,94 @@ bool TcpClient::disconnect()
 	close(this->m_socketDescriptor);
 #endif //defined(_WIN32)
     this->m_socketDescriptor = INVALID_SOCKET;
+    this->m_connectionLost = false;
     return true;
 }
 
 bool TcpClient::isConnected() const
 {
-    return this->m_socketDescriptor != INVALID_SOCKET;
+    return ( (this->m_socketDescriptor != INVALID_SOCKET) && (!this->m_connectionLost) );
+}
+
+void TcpClient::abandonConnection()
+{
+    //Another thread may be blocked on the descriptor, so it stays open until disconnect(). Shutting the
+    //socket down wakes that thread, and its next call fails instead of reaching a reused descriptor
+    this->m_connectionLost = true;
+#if defined(_WIN32)
+    (void)shutdown(this->m_socketDescriptor, SD_BOTH);
+#else
+    (void)shutdown(this->m_socketDescriptor, SHUT_RDWR);
+#endif //defined(_WIN32)
 }
 
 char TcpClient::read()
 {
-    if (!this->m_readBuffer.empty()) {
-        char returnValue{ this->m_readBuffer.front() };
-        this->m_readBuffer = this->m_readBuffer.substr(1);
-        return returnValue;
-    }
-
-    //Use select() to wait for data to arrive
-    //At socket, then read and return
-    fd_set read_fds{0, 0, 0};
-    fd_set write_fds{0, 0, 0};
-    fd_set except_fds{0, 0, 0};
-    FD_ZERO(&read_fds);
-    FD_ZERO(&write_fds);
-    FD_ZERO(&except_fds);
-    FD_SET(this->m_socketDescriptor, &read_fds);
-
-    struct timeval timeout{0, 0};
-    timeout.tv_sec = 0;
-    timeout.tv_usec = (this->readTimeout() * 1000);
-    static char readBuffer[TCP_CLIENT_BUFFER_MAX];
-    memset(readBuffer, '\0', TCP_CLIENT_BUFFER_MAX);
-
-    if (select(this->m_socketDescriptor + 1, &read_fds, &write_fds, &except_fds, &timeout) == 1) {
-        auto receiveResult = recv(this->m_socketDescriptor, readBuffer, TCP_CLIENT_BUFFER_MAX - 1, 0);
-        if (receiveResult == -1) {
+    if (this->m_readBuffer.empty()) {
+        //Received straight into the ring, the buffer is empty so the free space is one contiguous run
+        size_t space{0};
+        auto readBuffer = this->m_readBuffer.writable(&space);
+        auto receiveCount = this->receive(readBuffer, space, Deadline{std::chrono::milliseconds{this->readTimeout()}}, "read()");
+        if (receiveCount == 0) {
+            return 0;
+        }
+        //Binary data may follow a text header (see receiveToDescriptor()), so keep every byte, NULs included
+        this->m_readBuffer.commit(receiveCount);
+    }
+    return this->m_readBuffer.pop();
+}
+
+size_t TcpClient::readAvailable(char *buffer, size_t length, const Deadline &deadline)
+{
+    if ( (length == 0) || (!this->m_readBuffer.empty()) ) {
+        return this->m_readBuffer.read(buffer, length);
+    }
+    return this->receive(buffer, length, deadline, "readAvailable(char *, size_t, const Deadline &)");
+}
+
+size_t TcpClient::receive(char *buffer, size_t length, const Deadline &deadline, const char *caller)
+{
+    if (!this->isConnected()) {
+        throw std::runtime_error(std::string{"CppSerialPort::TcpClient::"} + caller + ": Cannot read on closed socket (call connect first)");
+    }
+    if (!this->waitForEvents(POLLIN, deadline)) {
+        return 0;
+    }
+    auto receiveResult = recv(this->m_socketDescriptor, buffer, length, 0);
+    if (receiveResult == -1) {
+        auto errorCode = getLastError();
+        if ( (errorCode != EAGAIN) && (errorCode != EWOULDBLOCK) && (errorCode != EINTR) ) {
+            throw std::runtime_error(std::string{"CppSerialPort::TcpClient::"} + caller + ": recv(int, void *, size_t, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+        }
+        return 0;
+    } else if (receiveResult == 0) {
+        this->abandonConnection();
+        throw std::runtime_error(std::string{"CppSerialPort::TcpClient::"} + caller + ": Server [" + this->m_hostName + ':' + toStdString(this->m_portNumber) + "] hung up unexpectedly");
+    }
+    return static_cast<size_t>(receiveResult);
+}
+
+bool TcpClient::waitForEvents(short events, const Deadline &deadline)
+{
+    while (true) {
+#if defined(_WIN32)
+        WSAPOLLFD pollDescriptor{this->m_socketDescriptor, events, 0};
+        auto pollResult = WSAPoll(&pollDescriptor, 1, deadline.pollTimeout());
+#else
+        pollfd pollDescriptor{this->m_socketDescriptor, events, 0};
+        auto pollResult = poll(&pollDescriptor, 1, deadline.pollTimeout());
+#endif //defined(_WIN32)
+        if (pollResult == -1) {
             auto errorCode = getLastError();
-            if (errorCode != EAGAIN) {
-                throw std::runtime_error("CppSerialPort::TcpClient::read(): recv(int, void *, size_t, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+            //Interrupted, so wait again for what is left rather than the whole timeout
+            if (errorCode == EINTR) {
+                continue;
             }
-            return 0;
-        } else if (strlen(readBuffer) != 0) {
-            this->m_readBuffer += std::string{readBuffer};
-            char returnValue{this->m_readBuffer.front()};
-            this->m_readBuffer = this->m_readBuffer.substr(1);
-            return returnValue;
-        } else if (receiveResult == 0) {
-            this->closePort();
-            throw std::runtime_error("CppSerialPort::TcpClient::read(): Server [" + this->m_hostName + ':' + toStdString(this->m_portNumber) + "] hung up unexpectedly");
+            throw std::runtime_error("CppSerialPort::TcpClient::waitForEvents(short, const Deadline &): poll(pollfd *, nfds_t, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
         }
+        //POLLERR and POLLHUP count too, the recv() or send() that follows reports them
+        return (pollResult == 1);
     }
-    return 0;
 }
 
 ssize_t TcpClient::write(char c)
@@ -235,19 +328,53 @@ ssize_t TcpClient::write(const char *bytes, size_t numberOfBytes)
         throw std::runtime_error("CppSerialPort::TcpClient::write(const char *, size_t): Cannot write on closed socket (call connect first)");
     }
     unsigned sentBytes{0};
-    //Make sure all bytes are sent
-	auto startTime = IByteStream::getEpoch();
+    //Make sure all bytes are sent, waiting for room in the socket buffer only until the write timeout runs out
+    Deadline deadline{std::chrono::milliseconds{this->writeTimeout()}};
+#if !defined(_WIN32)
+    auto allowZeroCopy = this->m_zeroCopyEnabled;
+#endif //!defined(_WIN32)
     while (sentBytes < numberOfBytes)  {
-        auto sendResult = send(this->m_socketDescriptor, bytes + sentBytes, numberOfBytes - sentBytes, 0);
+        int flags{0};
+#if !defined(_WIN32)
+        //Never blocks in send(), a full socket buffer is waited out with poll() against the deadline instead.
+        //A peer gone away fails the send with EPIPE rather than raising SIGPIPE
+        flags |= (MSG_DONTWAIT | MSG_NOSIGNAL);
+        auto zeroCopy = ( (allowZeroCopy) && ((numberOfBytes - sentBytes) >= this->m_zeroCopyThreshold) );
+        flags |= (zeroCopy ? ZeroCopy::SEND_FLAG : 0);
+#endif //!defined(_WIN32)
+        auto sendResult = send(this->m_socketDescriptor, bytes + sentBytes, numberOfBytes - sentBytes, flags);
         if (sendResult == -1) {
 			auto errorCode = getLastError();
+#if !defined(_WIN32)
+            if ( (zeroCopy) && (errorCode == ENOBUFS) ) {
+                //Out of option memory to track more zero copy sends, copy the rest of this write
+                allowZeroCopy = false;
+                continue;
+            }
+#endif //!defined(_WIN32)
+            if (errorCode == EINTR) {
+                continue;
+            } else if ( (errorCode == EAGAIN) || (errorCode == EWOULDBLOCK) ) {
+#if !defined(_WIN32)
+                //Completions queued on the error queue raise POLLERR, which would wake the wait below straight away
+                this->reapZeroCopy();
+#endif //!defined(_WIN32)
+                if (!this->waitForEvents(POLLOUT, deadline)) {
+                    break;
+                }
+                continue;
+            }
             throw std::runtime_error("CppSerialPort::TcpClient::write(const char *bytes, size_t): send(int, const void *, int, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
         }
+#if !defined(_WIN32)
+        this->m_zeroCopyPending += (zeroCopy ? 1 : 0);
+#endif //!defined(_WIN32)
         sentBytes += sendResult;
-		if ( (getEpoch() - startTime) >= static_cast<unsigned int>(this->writeTimeout()) ) {
-			break;
-		}
     }
+#if !defined(_WIN32)
+    //The kernel sends straight from the caller's pages, which must not change until every send has completed
+    this->awaitZeroCopy(deadline);
+#endif //!defined(_WIN32)
     return sentBytes;
 }
 
@@ -270,7 +397,7 @@ void TcpClient::openPort()
 
 void TcpClient::closePort()
 {
-    if (this->isConnected()) {
+    if (this->m_socketDescriptor != INVALID_SOCKET) {
         this->disconnect();
     }
 }
@@ -287,7 +414,141 @@ void TcpClient::flushTx()
 
 void TcpClient::putBack(char c)
 {
-    this->m_readBuffer.insert(this->m_readBuffer.begin(), c);
+    this->m_readBuffer.putBack(c);
+}
+
+void TcpClient::putBack(const char *data, size_t length)
+{
+    this->m_readBuffer.putBack(data, length);
+}
+
+size_t TcpClient::receiveToDescriptor(int fileDescriptor, size_t length)
+{
+    if (!this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::TcpClient::receiveToDescriptor(int, size_t): Cannot receive on closed socket (call connect first)");
+    }
+#if defined(_WIN32)
+    (void)fileDescriptor;
+    (void)length;
+    throw std::runtime_error("CppSerialPort::TcpClient::receiveToDescriptor(int, size_t): splice() is not available on this platform");
+#else
+    auto fail = [](const std::string &call, int errorCode) {
+        throw std::runtime_error("CppSerialPort::TcpClient::receiveToDescriptor(int, size_t): " + call + ": error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    };
+    size_t written{0};
+    //Whatever read() pulled in past a header goes out first, with a plain write()
+    while ( (written < length) && (!this->m_readBuffer.empty()) ) {
+        size_t buffered{0};
+        auto data = this->m_readBuffer.readable(&buffered);
+        auto writeResult = ::write(fileDescriptor, data, std::min(length - written, buffered));
+        if (writeResult == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("write(int, const void *, size_t)", errno);
+        }
+        this->m_readBuffer.consume(static_cast<size_t>(writeResult));
+        written += static_cast<size_t>(writeResult);
+    }
+    if (written == length) {
+        return written;
+    }
+    //The rest moves socket -> pipe -> file inside the kernel
+    int pipeDescriptors[2]{-1, -1};
+    if (pipe2(pipeDescriptors, O_CLOEXEC) == -1) {
+        fail("pipe2(int *, int)", errno);
+    }
+    auto closePipe = [&pipeDescriptors]() {
+        close(pipeDescriptors[0]);
+        close(pipeDescriptors[1]);
+    };
+    while (written < length) {
+        //Each wait gets the whole read timeout, so a long transfer only stops once the peer stalls that long
+        if (!this->waitForEvents(POLLIN, Deadline{std::chrono::milliseconds{this->readTimeout()}})) {
+            break;
+        }
+        auto receiveResult = splice(this->m_socketDescriptor, nullptr, pipeDescriptors[1], nullptr, std::min<size_t>(length - written, TCP_CLIENT_SPLICE_MAX), SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+        if (receiveResult == -1) {
+            auto errorCode = errno;
+            if ( (errorCode == EINTR) || (errorCode == EAGAIN) || (errorCode == EWOULDBLOCK) ) {
+                continue;
+            }
+            closePipe();
+            fail("splice(int, loff_t *, int, loff_t *, size_t, unsigned int)", errorCode);
+        } else if (receiveResult == 0) {
+            closePipe();
+            this->abandonConnection();
+            throw std::runtime_error("CppSerialPort::TcpClient::receiveToDescriptor(int, size_t): Server [" + this->m_hostName + ':' + toStdString(this->m_portNumber) + "] hung up unexpectedly");
+        }
+        auto piped = static_cast<size_t>(receiveResult);
+        while (piped > 0) {
+            auto writeResult = splice(pipeDescriptors[0], nullptr, fileDescriptor, nullptr, piped, SPLICE_F_MOVE);
+            if (writeResult == -1) {
+                auto errorCode = errno;
+                if (errorCode == EINTR) {
+                    continue;
+                }
+                closePipe();
+                fail("splice(int, loff_t *, int, loff_t *, size_t, unsigned int)", errorCode);
+            }
+            piped -= static_cast<size_t>(writeResult);
+            written += static_cast<size_t>(writeResult);
+        }
+    }
+    closePipe();
+    return written;
+#endif //defined(_WIN32)
+}
+
+void TcpClient::reapZeroCopy()
+{
+#if !defined(_WIN32)
+    if (this->m_zeroCopyPending == 0) {
+        return;
+    }
+    std::vector<ZeroCopy::Completion> completions{};
+    if (!ZeroCopy::readCompletions(this->m_socketDescriptor, completions)) {
+        auto errorCode = getLastError();
+        throw std::runtime_error("CppSerialPort::TcpClient::write(const char *, size_t): recvmsg(int, msghdr *, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    for (const auto &it : completions) {
+        this->m_zeroCopyPending -= std::min(this->m_zeroCopyPending, it.last - it.first + 1);
+        //The kernel copied anyway (loopback, or no scatter-gather), so pinning pages only adds cost
+        this->m_zeroCopyEnabled = ( (this->m_zeroCopyEnabled) && (!it.copied) );
+    }
+#endif //!defined(_WIN32)
+}
+
+void TcpClient::awaitZeroCopy(const Deadline &deadline)
+{
+#if defined(_WIN32)
+    (void)deadline;
+#else
+    while (true) {
+        this->reapZeroCopy();
+        if (this->m_zeroCopyPending == 0) {
+            break;
+        }
+        int socketError{0};
+        socklen_t socketErrorLength{sizeof(socketError)};
+        (void)getsockopt(this->m_socketDescriptor, SOL_SOCKET, SO_ERROR, &socketError, &socketErrorLength);
+        if ( (socketError != 0) || (deadline.expired()) ) {
+            //Returning would hand the caller back pages the kernel may still read, so reset the connection,
+            //which discards the unsent data and releases them. Disconnecting with an AF_UNSPEC connect()
+            //does that without closing the descriptor, which a reading thread may still be using
+            sockaddr unspecified{};
+            unspecified.sa_family = AF_UNSPEC;
+            (void)::connect(this->m_socketDescriptor, &unspecified, sizeof(unspecified));
+            this->abandonConnection();
+            if (socketError != 0) {
+                throw std::runtime_error("CppSerialPort::TcpClient::write(const char *, size_t): zero copy send failed: error code " + toStdString(socketError) + " (" + getErrorString(socketError) + ')');
+            }
+            throw std::runtime_error("CppSerialPort::TcpClient::write(const char *, size_t): zero copy send did not complete within the write timeout");
+        }
+        //POLLERR is always reported, and the completions arrive on the error queue
+        (void)this->waitForEvents(0, deadline);
+    }
+#endif //defined(_WIN32)
 }
 
 timeval TcpClient::toTimeVal(uint32_t totalTimeout)
@@ -298,6 +559,17 @@ timeval TcpClient::toTimeVal(uint32_t totalTimeout)
     return tv;
 }
 
+void TcpClient::setConnectTimeout(int timeout) {
+    if (timeout < 0) {
+        throw std::runtime_error("CppSerialPort::TcpClient::setConnectTimeout(int): invariant failure (connect timeout cannot be less than 0, " + toStdString(timeout) + " < 0)");
+    }
+    this->m_connectTimeout = timeout;
+}
+
+int TcpClient::connectTimeout() const {
+    return this->m_connectTimeout;
+}
+
 void TcpClient::setPortNumber(uint16_t portNumber) {
     if (this->isConnected()) {
         throw std::runtime_error("CppSerialPort::TcpClient::setPortNumber(uint16_t): Cannot set port number when already connected (call disconnect() first)");
@@ -320,4 +592,42 @@ std::string TcpClient::hostName() const {
     return this->m_hostName;
 }
 
+void TcpClient::setSocketProfile(SocketTuning::Profile socketProfile) {
+    this->m_socketTuning = SocketTuning{socketProfile};
+}
+
+SocketTuning::Profile TcpClient::socketProfile() const {
+    return this->m_socketTuning.profile();
+}
+
+SocketTuning TcpClient::effectiveSocketTuning() const {
+#if defined(_WIN32)
+    return SocketTuning{};
+#else
+    return (this->isConnected() ? SocketTuning::fromDescriptor(this->m_socketDescriptor) : SocketTuning{});
+#endif //defined(_WIN32)
+}
+
+void TcpClient::setZeroCopyThreshold(size_t zeroCopyThreshold) {
+    this->m_zeroCopyThreshold = zeroCopyThreshold;
+}
+
+size_t TcpClient::zeroCopyThreshold() const {
+    return this->m_zeroCopyThreshold;
+}
+
+void TcpClient::setReceiveBufferSize(size_t receiveBufferSize) {
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::TcpClient::setReceiveBufferSize(size_t): Cannot set receive buffer size when already connected (call disconnect() first)");
+    }
+    if (receiveBufferSize == 0) {
+        throw std::runtime_error("CppSerialPort::TcpClient::setReceiveBufferSize(size_t): invariant failure (receive buffer size cannot be 0)");
+    }
+    this->m_readBuffer = RingBuffer{receiveBufferSize};
+}
+
+size_t TcpClient::receiveBufferSize() const {
+    return this->m_readBuffer.capacity();
+}
+
 } //namespace CppSerialPort
@@ -14,16 +14,35 @@
 
 #include <sys/types.h>
 #include <memory>
+#include <atomic>
 #include "IByteStream.h"
+#include "SocketTuning.h"
+#include "RingBuffer.h"
 
 namespace CppSerialPort {
 
+/*
+ * Connected TCP socket. Every TcpClient owns its socket and its receive
+ * buffer and shares no mutable state with any other, so clients on different
+ * threads need no locking between them and one process can drive thousands
+ * in parallel. A single client may have one thread reading while another
+ * writes: the line and bulk reads of IByteStream serialize on the read lock
+ * and writeLine() on the write lock. The single byte read(), putBack() and
+ * receiveToDescriptor() take no lock and belong to the reading thread, and
+ * write() takes none either and belongs to the writing one. connect(), disconnect()
+ * and the setters must not overlap any other call. A reader that finds the
+ * peer gone, or a zero copy write that has to reset the connection, only marks
+ * the client disconnected and shuts the socket down, so the other thread's
+ * next call fails. The descriptor itself is closed by disconnect(), closePort()
+ * or the destructor, once neither thread is using the client
+ */
 class TcpClient : public IByteStream
 {
 public:
     TcpClient(const std::string &hostName, uint16_t portNumber);
     ~TcpClient() override;
 
+    using IByteStream::read;
     char read() override;
     ssize_t write(char i) override;
 	ssize_t write(const char *bytes, size_t numberOfBytes) override;
@@ -34,7 +53,14 @@ public:
     void flushRx() override;
     void flushTx() override;
     void putBack(char c) override;
+    //Moves up to length bytes from the connection straight into fileDescriptor with splice(), starting with
+    //anything read() already buffered. Returns the bytes written, fewer if no data arrived for the read timeout.
+    //Throws, and marks the client disconnected, if the peer closes first
+    size_t receiveToDescriptor(int fileDescriptor, size_t length);
 
+    //connect() gives up once the handshake has taken this many milliseconds, 0 (the default) waits as long as the kernel retries
+    void setConnectTimeout(int timeout);
+    int connectTimeout() const;
     void connect(const std::string &hostName, uint16_t portNumber);
     void connect();
     bool disconnect();
@@ -43,6 +69,26 @@ public:
     void setHostName(const std::string &hostName);
     uint16_t portNumber() const;
     std::string hostName() const;
+    //Takes effect on the next connect()
+    void setSocketProfile(SocketTuning::Profile socketProfile);
+    SocketTuning::Profile socketProfile() const;
+    //What the kernel actually applied to the connected socket
+    SocketTuning effectiveSocketTuning() const;
+    //Writes of at least this many bytes use MSG_ZEROCOPY where the kernel supports it, 0 (the default) always copies.
+    //write() still returns only once the kernel is done with the bytes, so this pays off for large writes only.
+    //Takes effect on the next connect()
+    void setZeroCopyThreshold(size_t zeroCopyThreshold);
+    size_t zeroCopyThreshold() const;
+    //Bytes received ahead of the reader that are held between reads, rounded up to a power of two.
+    //Allocated once per client and never cleared by a read
+    void setReceiveBufferSize(size_t receiveBufferSize);
+    size_t receiveBufferSize() const;
+
+    static const size_t DEFAULT_RECEIVE_BUFFER_SIZE;
+protected:
+    void putBack(const char *data, size_t length) override;
+    //Serves what read() already buffered first, otherwise receives straight into buffer
+    size_t readAvailable(char *buffer, size_t length, const Deadline &deadline) override;
 private:
 #if defined(_WIN32)
 	SOCKET m_socketDescriptor;
@@ -51,8 +97,24 @@ private:
 #endif //defined(_WIN32)
     uint16_t m_portNumber;
     std::string m_hostName;
-    std::string m_readBuffer;
+    //Bytes received but not yet read, including any handed back with putBack()
+    RingBuffer m_readBuffer;
+    SocketTuning m_socketTuning;
+    int m_connectTimeout;
+    size_t m_zeroCopyThreshold;
+    bool m_zeroCopyEnabled;
+    //Zero copy sends not yet reported complete on the error queue
+    uint32_t m_zeroCopyPending;
+    //Set from either thread once the connection is dead, the descriptor stays open until disconnect()
+    std::atomic<bool> m_connectionLost;
 
+    //Waits with poll() for any of events until deadline, retrying when interrupted. False if it passed first
+    bool waitForEvents(short events, const Deadline &deadline);
+    //Waits for data, then receives up to length bytes of it into buffer. 0 if none arrived before deadline
+    size_t receive(char *buffer, size_t length, const Deadline &deadline, const char *caller);
+    void abandonConnection();
+    void reapZeroCopy();
+    void awaitZeroCopy(const Deadline &deadline);
     static timeval toTimeVal(uint32_t totalTimeout);
 	static std::string getErrorString(int errorCode);
 	static int getLastError();
@@ -0,0 +1,1680 @@
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "IoUring.h"
+#include "ZeroCopy.h"
+#include "CpuAffinity.h"
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace CppSerialPort {
+
+const std::chrono::milliseconds TcpServer::DEFAULT_IDLE_TIMEOUT{60000};
+const std::chrono::milliseconds TcpServer::DEFAULT_READ_TIMEOUT{10000};
+const std::chrono::milliseconds TcpServer::DEFAULT_WRITE_TIMEOUT{30000};
+const size_t TcpServer::OUTPUT_HIGH_WATER_MARK{1024 * 1024};
+const size_t TcpServer::OUTPUT_LOW_WATER_MARK{256 * 1024};
+
+//Connections accepted per listener wakeup
+static const int ACCEPT_BATCH_SIZE{256};
+static const size_t RECEIVE_BUFFER_SIZE{16384};
+//A connection whose reads keep filling the buffer doubles its read size up to this
+static const size_t MAXIMUM_RECEIVE_SIZE{256 * 1024};
+static const size_t MAXIMUM_CONNECTION_TABLE_SIZE{1 << 24};
+
+#if defined(CPPSERIALPORT_HAS_IO_URING)
+static const unsigned URING_QUEUE_DEPTH{4096};
+static const unsigned URING_BUFFER_COUNT{1024};
+static const uint16_t URING_BUFFER_GROUP{0};
+static const size_t URING_GATHER_COUNT{64};
+
+//Completion user data is the UringConnection pointer, with the operation in the low (alignment) bits
+enum class UringOperation : uint64_t {
+    Accept = 1,
+    Receive = 2,
+    Send = 3,
+    Cancel = 4,
+    Timeout = 5,
+    Stop = 6,
+    Wakeup = 7
+};
+static const uint64_t URING_OPERATION_MASK{0x7};
+
+struct UringConnection
+{
+    std::shared_ptr<TcpConnection> connection;
+    //Must stay untouched while the gathered send is in flight
+    msghdr inFlightMessage;
+    std::vector<iovec> inFlightVectors;
+    bool receiveArmed;
+    bool sendInFlight;
+    //The in-flight "send" is a poll for room in the socket buffer, queued file ranges are sent directly once it completes
+    bool pollingWritable;
+    bool closing;
+};
+#endif //defined(CPPSERIALPORT_HAS_IO_URING)
+
+//Frames a strand task handled, handed back to the reactor that owns the connection
+struct StrandCompletion
+{
+    std::shared_ptr<TcpConnection> connection;
+    OutputQueue output;
+    size_t handledBytes;
+    bool closeRequested;
+    //onClose() has returned, so the reactor may close the descriptor
+    bool closed;
+};
+
+//Frames a strand task handles before it lets other connections' tasks run
+static const size_t STRAND_BATCH_SIZE{64};
+
+TcpConnection::TcpConnection(int socketDescriptor, const PeerAddress &peer, FramingMode framingMode, size_t maximumFrameSize) :
+    m_socketDescriptor{socketDescriptor},
+    m_peer{peer},
+    m_frameDecoder{framingMode, maximumFrameSize},
+    m_outputQueue{},
+    m_readPaused{false},
+    m_closeRequested{false},
+    m_closeDispatched{false},
+    m_idleTimer{},
+    m_readTimer{},
+    m_writeTimer{},
+    m_context{nullptr},
+    m_admissionSource{nullptr},
+    m_receiveSize{RECEIVE_BUFFER_SIZE},
+    m_strandMutex{},
+    m_strandFrames{},
+    m_strandScheduled{false},
+    m_strandClosed{false},
+    m_strandOutput{},
+    m_strandCloseRequested{false},
+    m_offloadedBytes{0}
+{
+
+}
+
+OutputQueue &TcpConnection::activeOutputQueue()
+{
+    //A handler thread never touches the queue the reactor is sending from
+    return (WorkStealingExecutor::isWorkerThread() ? this->m_strandOutput : this->m_outputQueue);
+}
+
+int TcpConnection::socketDescriptor() const
+{
+    return this->m_socketDescriptor;
+}
+
+const PeerAddress &TcpConnection::peer() const
+{
+    return this->m_peer;
+}
+
+void TcpConnection::sendStatic(const char *data, size_t length)
+{
+    this->activeOutputQueue().appendStatic(data, length);
+}
+
+void TcpConnection::sendBorrowed(const char *data, size_t length)
+{
+    this->activeOutputQueue().appendBorrowed(data, length);
+}
+
+void TcpConnection::send(const char *data, size_t length)
+{
+    this->activeOutputQueue().appendCopy(data, length);
+}
+
+void TcpConnection::send(const std::string &data)
+{
+    this->activeOutputQueue().appendCopy(data.data(), data.length());
+}
+
+void TcpConnection::sendFile(int fileDescriptor, off_t offset, size_t length)
+{
+    this->activeOutputQueue().appendFile(fileDescriptor, offset, length);
+}
+
+size_t TcpConnection::queuedBytes() const
+{
+    return (WorkStealingExecutor::isWorkerThread() ? this->m_strandOutput.size() : this->m_outputQueue.size());
+}
+
+void TcpConnection::close()
+{
+    if (WorkStealingExecutor::isWorkerThread()) {
+        this->m_strandCloseRequested = true;
+    } else {
+        this->m_closeRequested = true;
+    }
+}
+
+bool TcpConnection::isClosing() const
+{
+    return (WorkStealingExecutor::isWorkerThread() ? this->m_strandCloseRequested : this->m_closeRequested);
+}
+
+void TcpConnection::setContext(const std::shared_ptr<void> &context)
+{
+    this->m_context = context;
+}
+
+const std::shared_ptr<void> &TcpConnection::context() const
+{
+    return this->m_context;
+}
+
+//One listener, event loop and timer wheel per worker thread, only the connection table is shared
+class TcpServer::Reactor : public IEventHandler
+{
+public:
+    Reactor(TcpServer *server, int listenDescriptor);
+    ~Reactor() override;
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    void handleEvents(int descriptor, uint32_t events) override;
+    void run();
+    //Only writes to an eventfd, so it is async-signal-safe
+    void stop();
+    void closeListener();
+
+private:
+    TcpServer *m_server;
+    int m_listenDescriptor;
+    //Held open so it can be given up to accept, and drop, a connection when descriptors run out
+    int m_reserveDescriptor;
+    //Level-triggered, so a stop() that lands before the loop starts is still seen
+    int m_stopDescriptor;
+    EventLoop m_eventLoop;
+    //Re-arms the io_uring accept, which would otherwise fail straight away while descriptors are exhausted
+    Timer m_acceptRetryTimer;
+    //Wakes the reactor when handler threads have posted completions
+    int m_completionDescriptor;
+    std::mutex m_completionMutex;
+    //A deque, so queued responses never move once posted
+    std::deque<StrandCompletion> m_completions;
+    //This reactor's part of the server wide rate limits
+    AdmissionControl::Share m_admissionShare;
+    //Shared by every connection on the epoll engine, so an idle connection holds no receive buffer
+    PooledBuffer m_receiveBuffer;
+
+    bool handleReceivedData(const std::shared_ptr<TcpConnection> &connection, const char *buffer, size_t length);
+    void dispatchClose(const std::shared_ptr<TcpConnection> &connection);
+    void submitStrand(const std::shared_ptr<TcpConnection> &connection);
+    void runStrand(const std::shared_ptr<TcpConnection> &connection);
+    void postStrandCompletion(const std::shared_ptr<TcpConnection> &connection, size_t handledBytes, bool closed);
+    void releaseDescriptor(TcpConnection &connection);
+    std::deque<StrandCompletion> takeCompletions();
+    void handleCompletions();
+
+    void acceptConnections();
+    bool admitConnection(int socketDescriptor, const PeerAddress &peer, std::shared_ptr<AdmissionControl::Source> &source);
+    void addConnection(int socketDescriptor, const sockaddr *address, socklen_t addressLength);
+    bool shedPendingConnection(int errorCode);
+    void handleConnection(int socketDescriptor, uint32_t events);
+    void closeConnection(int socketDescriptor);
+    void expireConnection(int socketDescriptor, const std::string &reason);
+
+#if defined(CPPSERIALPORT_HAS_IO_URING)
+    //Every connection this reactor's ring still references, so shutdown can release them
+    //and completions from handler threads can find theirs
+    std::unordered_map<TcpConnection *, UringConnection *> m_uringConnections;
+
+    void runIoUring();
+    void submitUringAccept(IoUring &ring);
+    void submitUringPoll(IoUring &ring, int descriptor, UringOperation operation);
+    void handleUringCompletions(IoUring &ring);
+    void armUringReceive(IoUring &ring, UringConnection &uringConnection);
+    void flushUringConnection(IoUring &ring, UringConnection &uringConnection);
+    void cancelUringOperation(IoUring &ring, UringConnection &uringConnection, UringOperation operation);
+    void closeUringConnection(IoUring &ring, UringConnection &uringConnection);
+    void releaseUringConnection(UringConnection *uringConnection);
+    void handleUringCompletion(IoUring &ring, const io_uring_cqe &completion);
+    void acceptUringConnection(IoUring &ring, int socketDescriptor);
+    void handleUringReceive(IoUring &ring, UringConnection &uringConnection, const io_uring_cqe &completion);
+    void handleUringSend(IoUring &ring, UringConnection &uringConnection, const io_uring_cqe &completion);
+    bool closeUringConnectionIfRequested(IoUring &ring, UringConnection &uringConnection);
+#endif //defined(CPPSERIALPORT_HAS_IO_URING)
+};
+
+TcpServer::Reactor::Reactor(TcpServer *server, int listenDescriptor) :
+    m_server{server},
+    m_listenDescriptor{listenDescriptor},
+    m_reserveDescriptor{open("/dev/null", O_RDONLY | O_CLOEXEC)},
+    m_stopDescriptor{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)},
+    m_eventLoop{},
+    m_acceptRetryTimer{},
+    m_completionDescriptor{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)},
+    m_completionMutex{},
+    m_completions{},
+    m_admissionShare{server->m_admissionControl.createShare(static_cast<size_t>(server->m_workerCount))},
+    m_receiveBuffer{}
+{
+    if ( (this->m_stopDescriptor == -1) || (this->m_completionDescriptor == -1) ) {
+        auto errorCode = errno;
+        this->closeListener();
+        for (auto descriptor : {this->m_reserveDescriptor, this->m_stopDescriptor, this->m_completionDescriptor}) {
+            if (descriptor != -1) {
+                ::close(descriptor);
+            }
+        }
+        throw std::runtime_error("CppSerialPort::TcpServer::Reactor::Reactor(TcpServer *, int): eventfd(unsigned int, int): error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    }
+    this->m_eventLoop.addDescriptor(this->m_listenDescriptor, EPOLLIN, this);
+    this->m_eventLoop.addDescriptor(this->m_stopDescriptor, EPOLLIN, this);
+    this->m_eventLoop.addDescriptor(this->m_completionDescriptor, EPOLLIN, this);
+}
+
+TcpServer::Reactor::~Reactor()
+{
+    this->closeListener();
+    if (this->m_reserveDescriptor != -1) {
+        ::close(this->m_reserveDescriptor);
+    }
+    ::close(this->m_stopDescriptor);
+    ::close(this->m_completionDescriptor);
+}
+
+void TcpServer::Reactor::closeListener()
+{
+    if (this->m_listenDescriptor != -1) {
+        ::close(this->m_listenDescriptor);
+        this->m_listenDescriptor = -1;
+    }
+}
+
+void TcpServer::Reactor::stop()
+{
+    uint64_t wakeup{1};
+    auto writeResult = ::write(this->m_stopDescriptor, &wakeup, sizeof(wakeup));
+    (void)writeResult;
+}
+
+void TcpServer::Reactor::run()
+{
+#if defined(CPPSERIALPORT_HAS_IO_URING)
+    if (this->m_server->m_ioEngine == IoEngine::IoUring) {
+        try {
+            this->runIoUring();
+            //The ring is gone, so nothing references the connections any more
+            for (auto &it : this->m_uringConnections) {
+                delete it.second;
+            }
+            this->m_uringConnections.clear();
+            return;
+        } catch (std::exception &e) {
+            this->m_server->trace(std::string{"io_uring engine unavailable, falling back to epoll: "} + e.what());
+        }
+    }
+#endif //defined(CPPSERIALPORT_HAS_IO_URING)
+    this->m_eventLoop.run();
+}
+
+void TcpServer::Reactor::handleEvents(int descriptor, uint32_t events)
+{
+    if (descriptor == this->m_stopDescriptor) {
+        this->m_eventLoop.stop();
+    } else if (descriptor == this->m_completionDescriptor) {
+        this->handleCompletions();
+    } else if (descriptor == this->m_listenDescriptor) {
+        this->acceptConnections();
+    } else {
+        this->handleConnection(descriptor, events);
+    }
+}
+
+void TcpServer::Reactor::acceptConnections()
+{
+    //The listener is level-triggered, so whatever is left after one batch wakes the loop again,
+    //after the connections that are already open have had their turn
+    for (int i = 0; i < ACCEPT_BATCH_SIZE; i++) {
+        sockaddr_storage acceptedAddress{};
+        socklen_t acceptedAddressSize{sizeof(acceptedAddress)};
+        auto acceptResult = accept4(this->m_listenDescriptor, reinterpret_cast<sockaddr *>(&acceptedAddress), &acceptedAddressSize, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (acceptResult == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                return;
+            } else if (isTransientAcceptError(errno)) {
+                continue;
+            } else if ( (errno == EMFILE) || (errno == ENFILE) ) {
+                //The descriptor check comes before the queue check, so stop once nothing is left to drop
+                if (this->shedPendingConnection(errno)) {
+                    continue;
+                }
+                return;
+            }
+            //Out of memory or buffers, leave the rest queued until the next wakeup
+            this->m_server->trace("accept4(int, sockaddr *, socklen_t *, int): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+            return;
+        }
+        this->addConnection(acceptResult, reinterpret_cast<sockaddr *>(&acceptedAddress), acceptedAddressSize);
+    }
+}
+
+bool TcpServer::Reactor::admitConnection(int socketDescriptor, const PeerAddress &peer, std::shared_ptr<AdmissionControl::Source> &source)
+{
+    auto server = this->m_server;
+    if ( (!server->m_admissionControl.isEnabled()) || (server->m_admissionControl.admitConnection(this->m_admissionShare, peer, server->m_connections->size(), source)) ) {
+        return true;
+    }
+    //One non-blocking attempt, then close, so a rejection costs no more than the accept did
+    if (!server->m_overloadResponse.empty()) {
+        auto sendResult = ::send(socketDescriptor, server->m_overloadResponse.data(), server->m_overloadResponse.length(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        (void)sendResult;
+    }
+    ::close(socketDescriptor);
+    return false;
+}
+
+void TcpServer::Reactor::addConnection(int socketDescriptor, const sockaddr *address, socklen_t addressLength)
+{
+    auto server = this->m_server;
+    PeerAddress peer{address, addressLength};
+    std::shared_ptr<AdmissionControl::Source> admissionSource{nullptr};
+    if (!this->admitConnection(socketDescriptor, peer, admissionSource)) {
+        return;
+    }
+    server->tuneAcceptedConnection(socketDescriptor);
+    auto connection = std::make_shared<TcpConnection>(socketDescriptor, peer, server->m_framingMode, server->m_maximumFrameSize);
+    connection->m_admissionSource = std::move(admissionSource);
+    //Kernels without SO_ZEROCOPY just keep copying
+    if ( (server->m_zeroCopyThreshold != 0) && (ZeroCopy::enable(socketDescriptor)) ) {
+        connection->m_outputQueue.setZeroCopyThreshold(server->m_zeroCopyThreshold);
+    }
+    server->setConnectionTimeouts(*connection, [this, socketDescriptor](const std::string &reason) {
+        this->expireConnection(socketDescriptor, reason);
+    });
+    server->updateConnectionTimers(this->m_eventLoop.timerWheel(), *connection, false, false);
+    server->m_connections->insert(socketDescriptor, connection);
+    server->traceConnection("Incoming connection", *connection);
+    //EPOLLOUT is edge-triggered too, so it only fires when a full socket buffer drains
+    this->m_eventLoop.addDescriptor(socketDescriptor, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, this);
+    server->m_handler->onConnect(*connection);
+    if ( (!server->flushConnection(*connection)) || (connection->m_closeRequested) ) {
+        this->closeConnection(socketDescriptor);
+        return;
+    }
+    connection->m_outputQueue.retain();
+}
+
+bool TcpServer::Reactor::shedPendingConnection(int errorCode)
+{
+    //Out of descriptors, the pending connection would stay queued and keep the listener readable forever.
+    //Give up the reserve descriptor to accept it, close it so the peer sees a reset instead of hanging, then take the reserve back
+    if (this->m_reserveDescriptor != -1) {
+        ::close(this->m_reserveDescriptor);
+        this->m_reserveDescriptor = -1;
+    }
+    auto dropped = false;
+    pollfd listenPoll{this->m_listenDescriptor, POLLIN, 0};
+    if (poll(&listenPoll, 1, 0) == 1) {
+        auto acceptResult = accept4(this->m_listenDescriptor, nullptr, nullptr, SOCK_CLOEXEC);
+        if (acceptResult != -1) {
+            ::close(acceptResult);
+            dropped = true;
+        }
+    }
+    this->m_reserveDescriptor = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (dropped) {
+        this->m_server->trace(std::string{"Out of file descriptors ("} + strerror(errorCode) + "), dropped a pending connection");
+    }
+    return dropped;
+}
+
+void TcpServer::Reactor::handleConnection(int socketDescriptor, uint32_t events)
+{
+    auto server = this->m_server;
+    //Hold a reference, so closeConnection() does not destroy the connection underneath us
+    auto connection = server->m_connections->find(socketDescriptor);
+    if ( (!connection) || (connection->m_closeDispatched) ) {
+        return;
+    }
+    if (events & EPOLLERR) {
+        //Zero copy completions are queued on the error queue too, only a pending socket error is fatal
+        int socketError{0};
+        socklen_t socketErrorLength{sizeof(socketError)};
+        if ( (connection->m_outputQueue.zeroCopyThreshold() == 0) || (!connection->m_outputQueue.reapZeroCopy(socketDescriptor)) ||
+             (getsockopt(socketDescriptor, SOL_SOCKET, SO_ERROR, &socketError, &socketErrorLength) == -1) || (socketError != 0) ) {
+            server->traceConnection("Connection error", *connection);
+            this->closeConnection(socketDescriptor);
+            return;
+        }
+    }
+    auto bytesSent = connection->m_outputQueue.bytesSent();
+    auto received = false;
+    if (events & EPOLLOUT) {
+        if (!server->flushConnection(*connection)) {
+            this->closeConnection(socketDescriptor);
+            return;
+        }
+        //The edge for data that arrived while paused is long gone, so drain the socket now
+        if (server->resumeReadingIfDrained(*connection)) {
+            events |= EPOLLIN;
+        }
+    }
+    //While paused, unread data stays in the socket buffer and the peer's TCP window closes
+    if ( (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) || (connection->m_readPaused) ) {
+        server->updateConnectionTimers(this->m_eventLoop.timerWheel(), *connection, false, (connection->m_outputQueue.bytesSent() != bytesSent));
+        return;
+    }
+
+    if (!this->m_receiveBuffer) {
+        this->m_receiveBuffer = BufferPool::acquire(MAXIMUM_RECEIVE_SIZE);
+    }
+    auto buffer = this->m_receiveBuffer.data();
+    //Edge-triggered, so the socket must be drained until recv() would block
+    while (true) {
+        auto receiveResult = recv(socketDescriptor, buffer, connection->m_receiveSize, 0); //no flags
+        if (receiveResult == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            server->trace("recv(int, void *, size_t, int): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+            this->closeConnection(socketDescriptor);
+            return;
+        } else if (receiveResult == 0) {
+            server->flushConnection(*connection);
+            server->traceConnection("Connection closed", *connection);
+            this->closeConnection(socketDescriptor);
+            return;
+        }
+        received = true;
+        //Every frame in one read is handled before the flush, so a chatty peer keeps small reads and answers
+        //promptly, while a bulk flow that keeps filling them moves up to fewer, larger ones
+        auto receivedSize = static_cast<size_t>(receiveResult);
+        if (receivedSize == connection->m_receiveSize) {
+            connection->m_receiveSize = std::min(connection->m_receiveSize * 2, MAXIMUM_RECEIVE_SIZE);
+        } else if (receivedSize < (connection->m_receiveSize / 4)) {
+            connection->m_receiveSize = std::max(connection->m_receiveSize / 2, RECEIVE_BUFFER_SIZE);
+        }
+        if (!this->handleReceivedData(connection, buffer, receivedSize)) {
+            this->closeConnection(socketDescriptor);
+            return;
+        }
+        //Responses borrow from buffer, so whatever the socket does not take now is copied before the next recv()
+        if ( (!server->flushConnection(*connection)) || (connection->m_closeRequested) ) {
+            this->closeConnection(socketDescriptor);
+            return;
+        }
+        connection->m_outputQueue.retain();
+        connection->m_frameDecoder.releaseCompleted();
+        if (server->pauseReadingIfBacklogged(*connection)) {
+            break;
+        }
+    }
+    if (!server->flushConnection(*connection)) {
+        this->closeConnection(socketDescriptor);
+        return;
+    }
+    server->updateConnectionTimers(this->m_eventLoop.timerWheel(), *connection, received, (connection->m_outputQueue.bytesSent() != bytesSent));
+    //The peer caught up before any EPOLLOUT, so nothing else would wake the paused reader
+    if (server->resumeReadingIfDrained(*connection)) {
+        this->handleConnection(socketDescriptor, EPOLLIN);
+    }
+}
+
+void TcpServer::Reactor::expireConnection(int socketDescriptor, const std::string &reason)
+{
+    //Keeps the connection, and the timer that fired, alive until the close is done
+    auto connection = this->m_server->m_connections->find(socketDescriptor);
+    if ( (!connection) || (connection->m_closeDispatched) ) {
+        return;
+    }
+    this->m_server->traceConnection(reason + ", closing", *connection);
+    this->closeConnection(socketDescriptor);
+}
+
+void TcpServer::Reactor::closeConnection(int socketDescriptor)
+{
+    auto server = this->m_server;
+    auto connection = server->m_connections->find(socketDescriptor);
+    if ( (!connection) || (connection->m_closeDispatched) ) {
+        return;
+    }
+    server->cancelConnectionTimers(*connection);
+    this->m_eventLoop.removeDescriptor(socketDescriptor);
+    this->dispatchClose(connection);
+    //A handler thread still has onClose() to run, handleCompletions() closes the descriptor once it has
+    if (!server->m_executor) {
+        this->releaseDescriptor(*connection);
+    }
+}
+
+void TcpServer::Reactor::releaseDescriptor(TcpConnection &connection)
+{
+    //Remove before close(), so a concurrent accept() reusing the descriptor never sees the old entry
+    if (this->m_server->m_connections->remove(connection.m_socketDescriptor)) {
+        ::close(connection.m_socketDescriptor);
+    }
+}
+
+void TcpServer::Reactor::handleCompletions()
+{
+    uint64_t wakeupCount{0};
+    while (::read(this->m_completionDescriptor, &wakeupCount, sizeof(wakeupCount)) > 0) { }
+    auto server = this->m_server;
+    for (auto &it : this->takeCompletions()) {
+        auto &connection = *it.connection;
+        auto socketDescriptor = connection.m_socketDescriptor;
+        connection.m_offloadedBytes -= it.handledBytes;
+        if (it.closed) {
+            this->releaseDescriptor(connection);
+            continue;
+        }
+        //Output for a closing connection has nowhere to go, its descriptor only waits for onClose()
+        if ( (connection.m_closeDispatched) || (server->m_connections->find(socketDescriptor) != it.connection) ) {
+            continue;
+        }
+        auto bytesSent = connection.m_outputQueue.bytesSent();
+        connection.m_outputQueue.splice(it.output);
+        connection.m_closeRequested = ( (connection.m_closeRequested) || (it.closeRequested) );
+        if ( (!server->flushConnection(connection)) || (connection.m_closeRequested) ) {
+            this->closeConnection(socketDescriptor);
+            continue;
+        }
+        server->updateConnectionTimers(this->m_eventLoop.timerWheel(), connection, false, (connection.m_outputQueue.bytesSent() != bytesSent));
+        if (server->resumeReadingIfDrained(connection)) {
+            this->handleConnection(socketDescriptor, EPOLLIN);
+        }
+    }
+}
+
+bool TcpServer::Reactor::handleReceivedData(const std::shared_ptr<TcpConnection> &connection, const char *buffer, size_t length)
+{
+    auto server = this->m_server;
+    std::vector<TcpConnection::StrandFrame> frames{};
+    size_t frameBytes{0};
+    auto limitMessages = server->m_admissionControl.limitsMessages();
+    //One clock read covers every frame in the buffer
+    auto now = (limitMessages ? TokenBucket::Clock::now() : TokenBucket::Clock::time_point{});
+    //Every complete frame is handled before the caller flushes, so pipelined requests share one send
+    auto decodeResult = connection->m_frameDecoder.decode(buffer, length, [this, server, &connection, &frames, &frameBytes, limitMessages, now](const char *frame, size_t frameLength) {
+        auto admitted = ( (!limitMessages) || (server->m_admissionControl.admitMessage(this->m_admissionShare, connection->m_admissionSource.get(), frameLength, now)) );
+        if (server->m_executor) {
+            //The frame points into the receive buffer, so the handler thread gets its own copy
+            frames.push_back(TcpConnection::StrandFrame{(admitted ? std::string{frame, frameLength} : std::string{}), !admitted});
+            frameBytes += (admitted ? frameLength : 0);
+        } else if (!connection->m_closeRequested) {
+            //Frames after a close() are dropped, the handler is done with this peer
+            if (admitted) {
+                server->m_handler->onFrame(*connection, frame, frameLength);
+            } else {
+                connection->m_outputQueue.appendStatic(server->m_overloadResponse.data(), server->m_overloadResponse.length());
+            }
+        }
+    });
+    if (!frames.empty()) {
+        connection->m_offloadedBytes += frameBytes;
+        auto schedule = false;
+        {
+            std::lock_guard<std::mutex> strandLock{connection->m_strandMutex};
+            (void)strandLock;
+            for (auto &it : frames) {
+                connection->m_strandFrames.push_back(std::move(it));
+            }
+            schedule = (!connection->m_strandScheduled);
+            connection->m_strandScheduled = true;
+        }
+        if (schedule) {
+            this->submitStrand(connection);
+        }
+    }
+    if (!decodeResult) {
+        server->traceConnection("Frame exceeds " + std::to_string(connection->m_frameDecoder.maximumFrameSize()) + " bytes, closing", *connection);
+    }
+    return decodeResult;
+}
+
+void TcpServer::Reactor::dispatchClose(const std::shared_ptr<TcpConnection> &connection)
+{
+    connection->m_closeDispatched = true;
+    if (!this->m_server->m_executor) {
+        this->m_server->m_handler->onClose(*connection);
+        return;
+    }
+    //onClose() waits for a frame the handler is already working on, frames still queued are dropped
+    auto schedule = false;
+    {
+        std::lock_guard<std::mutex> strandLock{connection->m_strandMutex};
+        (void)strandLock;
+        connection->m_strandClosed = true;
+        connection->m_strandFrames.clear();
+        schedule = (!connection->m_strandScheduled);
+        connection->m_strandScheduled = true;
+    }
+    if (schedule) {
+        this->submitStrand(connection);
+    }
+}
+
+void TcpServer::Reactor::submitStrand(const std::shared_ptr<TcpConnection> &connection)
+{
+    this->m_server->m_executor->submit([this, connection]() { this->runStrand(connection); });
+}
+
+void TcpServer::Reactor::runStrand(const std::shared_ptr<TcpConnection> &connection)
+{
+    auto handler = this->m_server->m_handler;
+    size_t handledFrames{0};
+    size_t handledBytes{0};
+    for (; handledFrames < STRAND_BATCH_SIZE; handledFrames++) {
+        TcpConnection::StrandFrame frame{};
+        {
+            std::lock_guard<std::mutex> strandLock{connection->m_strandMutex};
+            (void)strandLock;
+            if ( (connection->m_strandClosed) || (connection->m_strandFrames.empty()) ) {
+                break;
+            }
+            frame = std::move(connection->m_strandFrames.front());
+            connection->m_strandFrames.pop_front();
+        }
+        handledBytes += frame.data.length();
+        if (connection->m_strandCloseRequested) {
+            continue;
+        } else if (frame.rejected) {
+            auto &overloadResponse = this->m_server->m_overloadResponse;
+            connection->m_strandOutput.appendStatic(overloadResponse.data(), overloadResponse.length());
+        } else {
+            handler->onFrame(*connection, frame.data.data(), frame.data.length());
+            //Responses may borrow from the frame, which goes away with this iteration
+            connection->m_strandOutput.retain();
+        }
+    }
+    //Posted while the strand is still held, so responses from the next task can never overtake these
+    if (handledFrames > 0) {
+        this->postStrandCompletion(connection, handledBytes, false);
+    }
+    auto closed = false;
+    auto remaining = false;
+    {
+        std::lock_guard<std::mutex> strandLock{connection->m_strandMutex};
+        (void)strandLock;
+        closed = connection->m_strandClosed;
+        remaining = (!connection->m_strandFrames.empty());
+        if ( (!closed) && (!remaining) ) {
+            connection->m_strandScheduled = false;
+        }
+    }
+    if (closed) {
+        //The strand stays scheduled for good, so nothing else runs for this connection
+        handler->onClose(*connection);
+        connection->m_strandOutput.clear();
+        //The descriptor stayed open for onClose(), the reactor closes it now
+        this->postStrandCompletion(connection, 0, true);
+    } else if (remaining) {
+        //Requeued rather than looping, so one busy connection cannot hold a handler thread
+        this->submitStrand(connection);
+    }
+}
+
+void TcpServer::Reactor::postStrandCompletion(const std::shared_ptr<TcpConnection> &connection, size_t handledBytes, bool closed)
+{
+    auto wakeup = false;
+    {
+        std::lock_guard<std::mutex> completionLock{this->m_completionMutex};
+        (void)completionLock;
+        wakeup = this->m_completions.empty();
+        this->m_completions.emplace_back();
+        auto &completion = this->m_completions.back();
+        completion.connection = connection;
+        completion.output.splice(connection->m_strandOutput);
+        completion.handledBytes = handledBytes;
+        completion.closeRequested = connection->m_strandCloseRequested;
+        completion.closed = closed;
+    }
+    if (wakeup) {
+        uint64_t wakeupCount{1};
+        auto writeResult = ::write(this->m_completionDescriptor, &wakeupCount, sizeof(wakeupCount));
+        (void)writeResult;
+    }
+}
+
+std::deque<StrandCompletion> TcpServer::Reactor::takeCompletions()
+{
+    std::deque<StrandCompletion> completions{};
+    std::lock_guard<std::mutex> completionLock{this->m_completionMutex};
+    (void)completionLock;
+    completions.swap(this->m_completions);
+    return completions;
+}
+
+#if defined(CPPSERIALPORT_HAS_IO_URING)
+void TcpServer::Reactor::runIoUring()
+{
+    //The ring must be created on the thread that submits to it (IORING_SETUP_SINGLE_ISSUER)
+    IoUring ring{URING_QUEUE_DEPTH};
+    ring.setupBufferRing(URING_BUFFER_GROUP, URING_BUFFER_COUNT, RECEIVE_BUFFER_SIZE);
+    this->submitUringAccept(ring);
+    this->submitUringPoll(ring, this->m_stopDescriptor, UringOperation::Stop);
+    this->submitUringPoll(ring, this->m_completionDescriptor, UringOperation::Wakeup);
+    auto &timerWheel = this->m_eventLoop.timerWheel();
+    //Must stay untouched while the timeout is armed
+    __kernel_timespec tickTimeout{};
+    auto tickArmed = false;
+    auto stopped = false;
+    while (!stopped) {
+        //A single timeout wakes the ring once per tick while connection timers are scheduled
+        if ( (!tickArmed) && (!timerWheel.empty()) ) {
+            auto timeout = std::chrono::milliseconds{timerWheel.millisecondsUntilNextTick()};
+            tickTimeout.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(timeout).count();
+            tickTimeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout % std::chrono::seconds{1}).count();
+            auto entry = ring.getSubmissionEntry();
+            entry->opcode = IORING_OP_TIMEOUT;
+            entry->addr = reinterpret_cast<uint64_t>(&tickTimeout);
+            entry->len = 1;
+            entry->user_data = static_cast<uint64_t>(UringOperation::Timeout);
+            tickArmed = true;
+        }
+        //One system call submits every queued send/re-arm and reaps the next batch of completions
+        ring.submit(1);
+        ring.processCompletions([this, &ring, &tickArmed, &stopped](const io_uring_cqe &completion) {
+            if (completion.user_data == static_cast<uint64_t>(UringOperation::Timeout)) {
+                tickArmed = false;
+                return;
+            } else if (completion.user_data == static_cast<uint64_t>(UringOperation::Stop)) {
+                stopped = true;
+                return;
+            }
+            this->handleUringCompletion(ring, completion);
+        });
+        timerWheel.advance();
+    }
+    //Closing leaves every connection marked, the ring going away then cancels what is still in flight
+    for (auto &it : this->m_uringConnections) {
+        this->closeUringConnection(ring, *it.second);
+    }
+}
+
+void TcpServer::Reactor::submitUringAccept(IoUring &ring)
+{
+    auto entry = ring.getSubmissionEntry();
+    entry->opcode = IORING_OP_ACCEPT;
+    entry->fd = this->m_listenDescriptor;
+    entry->ioprio = IORING_ACCEPT_MULTISHOT;
+    //Non-blocking like the epoll engine's sockets, so sendfile() of a file range never stalls the ring.
+    //Receives and sends on the ring are unaffected, they wait for readiness inside the kernel either way
+    entry->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    entry->user_data = static_cast<uint64_t>(UringOperation::Accept);
+}
+
+void TcpServer::Reactor::submitUringPoll(IoUring &ring, int descriptor, UringOperation operation)
+{
+    auto entry = ring.getSubmissionEntry();
+    entry->opcode = IORING_OP_POLL_ADD;
+    entry->fd = descriptor;
+    entry->poll32_events = POLLIN;
+    entry->user_data = static_cast<uint64_t>(operation);
+}
+
+void TcpServer::Reactor::handleUringCompletions(IoUring &ring)
+{
+    uint64_t wakeupCount{0};
+    while (::read(this->m_completionDescriptor, &wakeupCount, sizeof(wakeupCount)) > 0) { }
+    auto server = this->m_server;
+    for (auto &it : this->takeCompletions()) {
+        auto &connection = *it.connection;
+        connection.m_offloadedBytes -= it.handledBytes;
+        if (it.closed) {
+            this->releaseDescriptor(connection);
+            continue;
+        }
+        auto found = this->m_uringConnections.find(&connection);
+        if ( (found == this->m_uringConnections.end()) || (found->second->closing) ) {
+            continue;
+        }
+        auto &uringConnection = *found->second;
+        connection.m_outputQueue.splice(it.output);
+        connection.m_closeRequested = ( (connection.m_closeRequested) || (it.closeRequested) );
+        if (this->closeUringConnectionIfRequested(ring, uringConnection)) {
+            this->releaseUringConnection(&uringConnection);
+            continue;
+        }
+        server->updateConnectionTimers(this->m_eventLoop.timerWheel(), connection, false, false);
+        if ( (server->resumeReadingIfDrained(connection)) && (!uringConnection.receiveArmed) ) {
+            this->armUringReceive(ring, uringConnection);
+        }
+        this->flushUringConnection(ring, uringConnection);
+        //Sending a file range directly can fail and close the connection
+        this->releaseUringConnection(&uringConnection);
+    }
+    this->submitUringPoll(ring, this->m_completionDescriptor, UringOperation::Wakeup);
+}
+
+void TcpServer::Reactor::armUringReceive(IoUring &ring, UringConnection &uringConnection)
+{
+    auto entry = ring.getSubmissionEntry();
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = uringConnection.connection->m_socketDescriptor;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = ring.bufferGroup();
+    entry->user_data = reinterpret_cast<uint64_t>(&uringConnection) | static_cast<uint64_t>(UringOperation::Receive);
+    uringConnection.receiveArmed = true;
+}
+
+void TcpServer::Reactor::flushUringConnection(IoUring &ring, UringConnection &uringConnection)
+{
+    //Only one send per connection is in flight, which keeps responses ordered
+    //and lets everything queued meanwhile go out together in the next send
+    if ( (uringConnection.sendInFlight) || (uringConnection.closing) ) {
+        return;
+    }
+    auto &connection = *uringConnection.connection;
+    if (connection.m_outputQueue.empty()) {
+        return;
+    }
+    //io_uring has no sendfile, and linked splices would need a pipe per send, so file ranges go out
+    //directly on the non-blocking socket, the same way the epoll engine sends them, and a full
+    //socket buffer re-arms a POLLOUT poll instead of holding up the reactor
+    if (connection.m_outputQueue.frontIsFile()) {
+        auto server = this->m_server;
+        auto bytesSent = connection.m_outputQueue.bytesSent();
+        auto flushResult = connection.m_outputQueue.flush(connection.m_socketDescriptor);
+        if (flushResult == OutputQueue::FlushResult::Error) {
+            server->trace("sendfile(int, int, off_t *, size_t): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+            this->closeUringConnection(ring, uringConnection);
+            return;
+        }
+        server->updateConnectionTimers(this->m_eventLoop.timerWheel(), connection, false, (connection.m_outputQueue.bytesSent() != bytesSent));
+        if (flushResult == OutputQueue::FlushResult::WouldBlock) {
+            auto entry = ring.getSubmissionEntry();
+            entry->opcode = IORING_OP_POLL_ADD;
+            entry->fd = connection.m_socketDescriptor;
+            entry->poll32_events = POLLOUT;
+            entry->user_data = reinterpret_cast<uint64_t>(&uringConnection) | static_cast<uint64_t>(UringOperation::Send);
+            uringConnection.sendInFlight = true;
+            uringConnection.pollingWritable = true;
+        }
+        return;
+    }
+    uringConnection.inFlightVectors.resize(URING_GATHER_COUNT);
+    uringConnection.inFlightMessage = msghdr{};
+    uringConnection.inFlightMessage.msg_iov = uringConnection.inFlightVectors.data();
+    uringConnection.inFlightMessage.msg_iovlen = connection.m_outputQueue.gather(uringConnection.inFlightVectors.data(), URING_GATHER_COUNT);
+    auto entry = ring.getSubmissionEntry();
+    entry->opcode = IORING_OP_SENDMSG;
+    entry->fd = connection.m_socketDescriptor;
+    entry->addr = reinterpret_cast<uint64_t>(&uringConnection.inFlightMessage);
+    entry->len = 1;
+    entry->msg_flags = MSG_NOSIGNAL;
+    entry->user_data = reinterpret_cast<uint64_t>(&uringConnection) | static_cast<uint64_t>(UringOperation::Send);
+    uringConnection.sendInFlight = true;
+}
+
+void TcpServer::Reactor::cancelUringOperation(IoUring &ring, UringConnection &uringConnection, UringOperation operation)
+{
+    auto entry = ring.getSubmissionEntry();
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->addr = reinterpret_cast<uint64_t>(&uringConnection) | static_cast<uint64_t>(operation);
+    entry->user_data = static_cast<uint64_t>(UringOperation::Cancel);
+}
+
+void TcpServer::Reactor::closeUringConnection(IoUring &ring, UringConnection &uringConnection)
+{
+    if (uringConnection.closing) {
+        return;
+    }
+    uringConnection.closing = true;
+    auto server = this->m_server;
+    auto &connection = *uringConnection.connection;
+    server->cancelConnectionTimers(connection);
+    this->dispatchClose(uringConnection.connection);
+    if (uringConnection.receiveArmed) {
+        this->cancelUringOperation(ring, uringConnection, UringOperation::Receive);
+    }
+    //A send to a peer that stopped reading would otherwise hold the socket open indefinitely
+    if (uringConnection.sendInFlight) {
+        this->cancelUringOperation(ring, uringConnection, UringOperation::Send);
+    }
+    //A handler thread still has onClose() to run, handleUringCompletions() closes the descriptor once it has
+    if (!server->m_executor) {
+        this->releaseDescriptor(connection);
+    }
+}
+
+bool TcpServer::Reactor::closeUringConnectionIfRequested(IoUring &ring, UringConnection &uringConnection)
+{
+    //Reading stops once the handler asks to close, and the socket closes as soon as the queued output is out
+    auto &connection = *uringConnection.connection;
+    if (!connection.m_closeRequested) {
+        return false;
+    }
+    if (uringConnection.receiveArmed) {
+        this->cancelUringOperation(ring, uringConnection, UringOperation::Receive);
+    }
+    this->flushUringConnection(ring, uringConnection);
+    if (!uringConnection.sendInFlight) {
+        this->closeUringConnection(ring, uringConnection);
+    }
+    return true;
+}
+
+void TcpServer::Reactor::releaseUringConnection(UringConnection *uringConnection)
+{
+    //Completions still reference the connection until the last armed operation finishes
+    if ( (uringConnection->closing) && (!uringConnection->receiveArmed) && (!uringConnection->sendInFlight) ) {
+        this->m_uringConnections.erase(uringConnection->connection.get());
+        delete uringConnection;
+    }
+}
+
+void TcpServer::Reactor::handleUringCompletion(IoUring &ring, const io_uring_cqe &completion)
+{
+    auto operation = static_cast<UringOperation>(completion.user_data & URING_OPERATION_MASK);
+    auto uringConnection = reinterpret_cast<UringConnection *>(completion.user_data & ~URING_OPERATION_MASK);
+    switch (operation) {
+        case UringOperation::Accept:
+            if (completion.res >= 0) {
+                this->acceptUringConnection(ring, completion.res);
+            } else if ( (completion.res == -EMFILE) || (completion.res == -ENFILE) ) {
+                if ( (!this->shedPendingConnection(-completion.res)) && (!(completion.flags & IORING_CQE_F_MORE)) ) {
+                    //Nothing was pending, so retry on the next tick instead of spinning on the same error
+                    this->m_acceptRetryTimer.setCallback([this, &ring]() { this->submitUringAccept(ring); });
+                    this->m_eventLoop.timerWheel().schedule(this->m_acceptRetryTimer, this->m_eventLoop.timerWheel().tickInterval());
+                    break;
+                }
+            } else if ( (completion.res != -EAGAIN) && (!isTransientAcceptError(-completion.res)) ) {
+                this->m_server->trace("io_uring accept: error code " + std::to_string(-completion.res) + " (" + strerror(-completion.res) + ')');
+            }
+            if (!(completion.flags & IORING_CQE_F_MORE)) {
+                this->submitUringAccept(ring);
+            }
+            break;
+        case UringOperation::Receive:
+            this->handleUringReceive(ring, *uringConnection, completion);
+            this->releaseUringConnection(uringConnection);
+            break;
+        case UringOperation::Send:
+            this->handleUringSend(ring, *uringConnection, completion);
+            this->releaseUringConnection(uringConnection);
+            break;
+        case UringOperation::Wakeup:
+            this->handleUringCompletions(ring);
+            break;
+        case UringOperation::Cancel:
+        case UringOperation::Timeout:
+        case UringOperation::Stop:
+            break;
+    }
+}
+
+void TcpServer::Reactor::acceptUringConnection(IoUring &ring, int socketDescriptor)
+{
+    auto server = this->m_server;
+    auto peer = PeerAddress::fromDescriptor(socketDescriptor);
+    std::shared_ptr<AdmissionControl::Source> admissionSource{nullptr};
+    if (!this->admitConnection(socketDescriptor, peer, admissionSource)) {
+        return;
+    }
+    server->tuneAcceptedConnection(socketDescriptor);
+    auto connection = std::make_shared<TcpConnection>(socketDescriptor, peer, server->m_framingMode, server->m_maximumFrameSize);
+    connection->m_admissionSource = std::move(admissionSource);
+    server->m_connections->insert(socketDescriptor, connection);
+    server->traceConnection("Incoming connection", *connection);
+    auto uringConnection = new UringConnection{connection, msghdr{}, std::vector<iovec>{}, false, false, false, false};
+    this->m_uringConnections.emplace(connection.get(), uringConnection);
+    //The UringConnection outlives its timers, which closeUringConnection() cancels
+    server->setConnectionTimeouts(*connection, [this, &ring, uringConnection](const std::string &reason) {
+        this->m_server->traceConnection(reason + ", closing", *uringConnection->connection);
+        this->closeUringConnection(ring, *uringConnection);
+        this->releaseUringConnection(uringConnection);
+    });
+    server->updateConnectionTimers(this->m_eventLoop.timerWheel(), *connection, false, false);
+    server->m_handler->onConnect(*connection);
+    //Anything the handler queued must not borrow from the stack, the send completes later
+    connection->m_outputQueue.retain();
+    if (this->closeUringConnectionIfRequested(ring, *uringConnection)) {
+        this->releaseUringConnection(uringConnection);
+        return;
+    }
+    this->armUringReceive(ring, *uringConnection);
+    this->flushUringConnection(ring, *uringConnection);
+}
+
+void TcpServer::Reactor::handleUringReceive(IoUring &ring, UringConnection &uringConnection, const io_uring_cqe &completion)
+{
+    auto server = this->m_server;
+    auto &connection = *uringConnection.connection;
+    if (!(completion.flags & IORING_CQE_F_MORE)) {
+        uringConnection.receiveArmed = false;
+    }
+    if (completion.flags & IORING_CQE_F_BUFFER) {
+        auto bufferId = static_cast<uint16_t>(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+        auto decodeResult = true;
+        //Receives that complete after the handler asked to close are dropped
+        if ( (completion.res > 0) && (!uringConnection.closing) && (!connection.m_closeRequested) ) {
+            decodeResult = this->handleReceivedData(uringConnection.connection, ring.buffer(bufferId), static_cast<size_t>(completion.res));
+            //The provided buffer goes straight back to the kernel, and the send completes later, so keep a copy
+            connection.m_outputQueue.retain();
+            connection.m_frameDecoder.releaseCompleted();
+            //Receives already completed still arrive, but the cancel stops the multishot from producing more
+            if ( (server->pauseReadingIfBacklogged(connection)) && (uringConnection.receiveArmed) ) {
+                this->cancelUringOperation(ring, uringConnection, UringOperation::Receive);
+            }
+            server->updateConnectionTimers(this->m_eventLoop.timerWheel(), connection, true, false);
+        }
+        ring.recycleBuffer(bufferId);
+        if (!decodeResult) {
+            this->closeUringConnection(ring, uringConnection);
+            return;
+        }
+    }
+    if (uringConnection.closing) {
+        return;
+    }
+    if (completion.res == 0) {
+        server->traceConnection("Connection closed", connection);
+        this->closeUringConnection(ring, uringConnection);
+        return;
+    } else if ( (completion.res < 0) && (completion.res != -ENOBUFS) && (completion.res != -ECANCELED) ) {
+        server->trace("io_uring recv: error code " + std::to_string(-completion.res) + " (" + strerror(-completion.res) + ')');
+        this->closeUringConnection(ring, uringConnection);
+        return;
+    }
+    if (this->closeUringConnectionIfRequested(ring, uringConnection)) {
+        return;
+    }
+    //Multishot receive stops when the provided buffers run dry, or when reading was paused and since resumed
+    if ( (!uringConnection.receiveArmed) && (!connection.m_readPaused) ) {
+        this->armUringReceive(ring, uringConnection);
+    }
+    this->flushUringConnection(ring, uringConnection);
+}
+
+void TcpServer::Reactor::handleUringSend(IoUring &ring, UringConnection &uringConnection, const io_uring_cqe &completion)
+{
+    auto server = this->m_server;
+    auto &connection = *uringConnection.connection;
+    uringConnection.sendInFlight = false;
+    if (uringConnection.closing) {
+        return;
+    }
+    if (completion.res < 0) {
+        server->trace("io_uring sendmsg: error code " + std::to_string(-completion.res) + " (" + strerror(-completion.res) + ')');
+        this->closeUringConnection(ring, uringConnection);
+        return;
+    }
+    //A poll result is an event mask, not a byte count, nothing was sent yet
+    if (uringConnection.pollingWritable) {
+        uringConnection.pollingWritable = false;
+    } else {
+        connection.m_outputQueue.consume(static_cast<size_t>(completion.res));
+        server->updateConnectionTimers(this->m_eventLoop.timerWheel(), connection, false, (completion.res > 0));
+    }
+    if (this->closeUringConnectionIfRequested(ring, uringConnection)) {
+        return;
+    }
+    //A receive whose cancel has not completed yet is re-armed by its final completion instead
+    if ( (server->resumeReadingIfDrained(connection)) && (!uringConnection.receiveArmed) ) {
+        this->armUringReceive(ring, uringConnection);
+    }
+    this->flushUringConnection(ring, uringConnection);
+}
+#endif //defined(CPPSERIALPORT_HAS_IO_URING)
+
+TcpServer::TcpServer(const std::string &hostName, uint16_t portNumber, ITcpServerHandler *handler) :
+    m_hostName{hostName},
+    m_portNumber{portNumber},
+    m_handler{handler},
+    m_workerCount{1},
+    m_handlerThreadCount{0},
+    m_ioEngine{IoEngine::Epoll},
+    m_workerCpus{},
+    m_incomingCpuSteering{false},
+    m_framingMode{FramingMode::LineDelimited},
+    m_maximumFrameSize{FrameDecoder::DEFAULT_MAXIMUM_FRAME_SIZE},
+    m_idleTimeout{DEFAULT_IDLE_TIMEOUT},
+    m_readTimeout{DEFAULT_READ_TIMEOUT},
+    m_writeTimeout{DEFAULT_WRITE_TIMEOUT},
+    m_listenBacklog{SOMAXCONN},
+    m_deferAccept{0},
+    m_socketTuning{},
+    m_zeroCopyThreshold{0},
+    m_admissionControl{},
+    m_overloadResponse{},
+    m_trafficLog{nullptr},
+    m_running{false},
+    m_stopRequested{false},
+    m_connections{nullptr},
+    m_reactors{},
+    m_executor{nullptr}
+{
+    if (handler == nullptr) {
+        throw std::runtime_error("CppSerialPort::TcpServer::TcpServer(const std::string &, uint16_t, ITcpServerHandler *): handler cannot be null");
+    }
+}
+
+TcpServer::~TcpServer()
+{
+    this->stop();
+}
+
+void TcpServer::run()
+{
+    if (this->m_running) {
+        throw std::runtime_error("CppSerialPort::TcpServer::run(): Server is already running (call stop() first)");
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC; //IPV4 or IPV6
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addressInfo{nullptr};
+    auto returnStatus = getaddrinfo(this->m_hostName.c_str(), std::to_string(this->m_portNumber).c_str(), &hints, &addressInfo);
+    if (returnStatus != 0) {
+        throw std::runtime_error("CppSerialPort::TcpServer::run(): getaddrinfo(const char *, const char *, constr addrinfo *, addrinfo **): error code " + std::to_string(returnStatus) + " (" + gai_strerror(returnStatus) + ')');
+    }
+#if !defined(CPPSERIALPORT_HAS_IO_URING)
+    if (this->m_ioEngine == IoEngine::IoUring) {
+        this->trace("io_uring support was not compiled in, falling back to epoll");
+    }
+#endif //!defined(CPPSERIALPORT_HAS_IO_URING)
+    this->m_reactors.clear();
+    this->m_admissionControl.clear();
+    this->m_connections.reset(new ConnectionTable<TcpConnection>{connectionTableSize()});
+    try {
+        //Every reactor binds its own SO_REUSEPORT listener, so the kernel spreads
+        //incoming connections across them and there is no shared accept queue
+        for (int i = 0; i < this->m_workerCount; i++) {
+            auto listenDescriptor = this->createListenSocket(addressInfo, (this->m_workerCount > 1));
+            if ( (this->m_incomingCpuSteering) && (!this->m_workerCpus.empty()) &&
+                 (!CpuAffinity::setIncomingCpu(listenDescriptor, this->m_workerCpus[i % this->m_workerCpus.size()])) ) {
+                this->trace("setsockopt(int, int, int, const void *, socklen_t) SO_INCOMING_CPU: error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+            }
+            this->m_reactors.emplace_back(new Reactor{this, listenDescriptor});
+        }
+    } catch (...) {
+        freeaddrinfo(addressInfo);
+        this->m_reactors.clear();
+        throw;
+    }
+    freeaddrinfo(addressInfo);
+    if (this->m_handlerThreadCount > 0) {
+        this->m_executor.reset(new WorkStealingExecutor{static_cast<size_t>(this->m_handlerThreadCount)});
+    }
+
+    //stop() only signals reactors once this is set, and a stop() that came first is caught below
+    this->m_running = true;
+    if (this->m_stopRequested) {
+        this->m_reactors.front()->stop();
+    }
+    //Bound before the reactor runs, so everything it allocates for its connections lands on its own node
+    auto runReactor = [this](size_t i) {
+        std::unique_ptr<CpuAffinity::ThreadBinding> binding{nullptr};
+        if (!this->m_workerCpus.empty()) {
+            binding.reset(new CpuAffinity::ThreadBinding{this->m_workerCpus[i % this->m_workerCpus.size()]});
+            for (const auto &it : binding->errors()) {
+                this->trace(it);
+            }
+        }
+        this->m_reactors[i]->run();
+    };
+    if (!this->m_workerCpus.empty()) {
+        for (size_t i = 0; i < this->m_reactors.size(); i++) {
+            auto cpu = this->m_workerCpus[i % this->m_workerCpus.size()];
+            this->trace("Worker " + std::to_string(i) + " pinned to CPU " + std::to_string(cpu) + " (NUMA node " + std::to_string(CpuAffinity::numaNodeOfCpu(cpu)) + ')');
+        }
+    }
+    std::vector<std::thread> workerThreads{};
+    for (size_t i = 1; i < this->m_reactors.size(); i++) {
+        workerThreads.emplace_back(runReactor, i);
+    }
+    //The calling thread gets its affinity back once its reactor returns
+    runReactor(0);
+    //Whichever reactor saw the stop first, make sure the others see it too
+    for (auto &it : this->m_reactors) {
+        it->stop();
+    }
+    for (auto &it : workerThreads) {
+        it.join();
+    }
+    //Frames already handed off still get their onFrame(), and closed connections their onClose()
+    if (this->m_executor) {
+        this->m_executor->stop();
+        this->m_executor.reset();
+    }
+    this->closeRemainingConnections();
+    for (auto &it : this->m_reactors) {
+        it->closeListener();
+    }
+    this->m_stopRequested = false;
+    this->m_running = false;
+}
+
+void TcpServer::stop()
+{
+    this->m_stopRequested = true;
+    if (this->m_running) {
+        for (auto &it : this->m_reactors) {
+            it->stop();
+        }
+    }
+}
+
+bool TcpServer::isRunning() const
+{
+    return this->m_running;
+}
+
+size_t TcpServer::connectionCount() const
+{
+    return (this->m_connections ? this->m_connections->size() : 0);
+}
+
+void TcpServer::tuneAcceptedConnection(int socketDescriptor)
+{
+    for (const auto &it : this->m_socketTuning.applyToAccepted(socketDescriptor)) {
+        this->trace(it);
+    }
+}
+
+void TcpServer::closeRemainingConnections()
+{
+    //Every reactor has stopped, so nothing else touches the connections or their timer wheels
+    if (this->m_connections->size() > 0) {
+        this->trace("Closing " + std::to_string(this->m_connections->size()) + " active connection(s)");
+    }
+    this->m_connections->forEach([this](TcpConnection &connection) {
+        this->cancelConnectionTimers(connection);
+        //The executor has stopped, so a close it was handed has already had its onClose()
+        if (!connection.m_closeDispatched) {
+            this->m_handler->onClose(connection);
+        }
+        this->m_connections->remove(connection.m_socketDescriptor);
+        ::close(connection.m_socketDescriptor);
+    });
+}
+
+int TcpServer::createListenSocket(const addrinfo *listenAddress, bool reusePort)
+{
+    auto socketDescriptor = socket(listenAddress->ai_family, listenAddress->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, listenAddress->ai_protocol);
+    if (socketDescriptor == -1) {
+        throw std::runtime_error("CppSerialPort::TcpServer::createListenSocket(const addrinfo *, bool): socket(int, int, int): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    auto fail = [socketDescriptor](const std::string &call) {
+        auto errorCode = errno;
+        ::close(socketDescriptor);
+        throw std::runtime_error("CppSerialPort::TcpServer::createListenSocket(const addrinfo *, bool): " + call + ": error code " + std::to_string(errorCode) + " (" + strerror(errorCode) + ')');
+    };
+
+    //Address reuse only takes effect if it is set before bind()
+    int acceptReuse{1};
+    if (setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &acceptReuse, sizeof(acceptReuse)) == -1) {
+        fail("setsockopt(int, int, int, const void *, socklen_t) SO_REUSEADDR");
+    }
+    if ( (reusePort) && (setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEPORT, &acceptReuse, sizeof(acceptReuse)) == -1) ) {
+        fail("setsockopt(int, int, int, const void *, socklen_t) SO_REUSEPORT");
+    }
+    if (bind(socketDescriptor, listenAddress->ai_addr, listenAddress->ai_addrlen) == -1) {
+        fail("bind(int, sockaddr*, int)");
+    }
+    for (const auto &it : this->m_socketTuning.apply(socketDescriptor)) {
+        this->trace(it);
+    }
+    //Wake the listener only once the first request bytes are in, so accept() is never followed by an empty read
+    int deferAccept{static_cast<int>(this->m_deferAccept.count())};
+    if ( (deferAccept > 0) && (setsockopt(socketDescriptor, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferAccept, sizeof(deferAccept)) == -1) ) {
+        this->trace("setsockopt(int, int, int, const void *, socklen_t) TCP_DEFER_ACCEPT: error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+    }
+    //The kernel silently caps this at net.core.somaxconn
+    if (listen(socketDescriptor, this->m_listenBacklog) == -1) {
+        fail("listen(int, int)");
+    }
+    //Every listener gets the same options, so report what the kernel made of them once
+    if (this->m_reactors.empty()) {
+        this->trace("Socket profile " + SocketTuning::profileName(this->m_socketTuning.profile()) + ": " + SocketTuning::fromDescriptor(socketDescriptor).toString());
+    }
+    return socketDescriptor;
+}
+
+bool TcpServer::flushConnection(TcpConnection &connection)
+{
+    //Make sure all bytes are sent, or leave the remainder for the next EPOLLOUT
+    if (connection.m_outputQueue.flush(connection.m_socketDescriptor) == OutputQueue::FlushResult::Error) {
+        this->trace("sendmsg(int, const msghdr *, int): error code " + std::to_string(errno) + " (" + strerror(errno) + ')');
+        return false;
+    }
+    return true;
+}
+
+bool TcpServer::pauseReadingIfBacklogged(TcpConnection &connection)
+{
+    //Frames still with a handler thread count too, so a slow handler pushes back on the peer like a slow reader does
+    auto backlog = connection.m_outputQueue.size() + connection.m_offloadedBytes;
+    if ( (connection.m_readPaused) || (backlog < OUTPUT_HIGH_WATER_MARK) ) {
+        return false;
+    }
+    connection.m_readPaused = true;
+    this->traceConnection("Output queue holds " + std::to_string(backlog) + " bytes, pausing reads", connection);
+    return true;
+}
+
+bool TcpServer::resumeReadingIfDrained(TcpConnection &connection)
+{
+    if ( (!connection.m_readPaused) || ((connection.m_outputQueue.size() + connection.m_offloadedBytes) > OUTPUT_LOW_WATER_MARK) ) {
+        return false;
+    }
+    connection.m_readPaused = false;
+    this->traceConnection("Output queue drained, resuming reads", connection);
+    return true;
+}
+
+void TcpServer::setConnectionTimeouts(TcpConnection &connection, const std::function<void(const std::string &)> &expire)
+{
+    connection.m_idleTimer.setCallback([expire]() { expire("Idle timeout"); });
+    connection.m_readTimer.setCallback([expire]() { expire("Read timeout"); });
+    connection.m_writeTimer.setCallback([expire]() { expire("Write timeout"); });
+}
+
+void TcpServer::updateConnectionTimers(TimerWheel &timerWheel, TcpConnection &connection, bool received, bool sent)
+{
+    //Traffic either way counts as activity, so only a silent connection reaches the idle deadline
+    if ( (this->m_idleTimeout.count() > 0) && ((received) || (sent) || (!connection.m_idleTimer.isScheduled())) ) {
+        timerWheel.schedule(connection.m_idleTimer, this->m_idleTimeout);
+    }
+    //The deadline runs from the first byte of a frame, so trickling the rest in slowly does not extend it.
+    //A paused reader is waiting on the write deadline instead, the unfinished frame is not the peer's fault
+    if (this->m_readTimeout.count() > 0) {
+        if ( (connection.m_frameDecoder.pendingLength() == 0) || (connection.m_readPaused) ) {
+            connection.m_readTimer.cancel();
+        } else if (!connection.m_readTimer.isScheduled()) {
+            timerWheel.schedule(connection.m_readTimer, this->m_readTimeout);
+        }
+    }
+    //Queued responses must keep moving, a peer that stopped reading altogether is dropped
+    if (this->m_writeTimeout.count() > 0) {
+        if (connection.m_outputQueue.empty()) {
+            connection.m_writeTimer.cancel();
+        } else if ( (sent) || (!connection.m_writeTimer.isScheduled()) ) {
+            timerWheel.schedule(connection.m_writeTimer, this->m_writeTimeout);
+        }
+    }
+}
+
+void TcpServer::cancelConnectionTimers(TcpConnection &connection)
+{
+    connection.m_idleTimer.cancel();
+    connection.m_readTimer.cancel();
+    connection.m_writeTimer.cancel();
+}
+
+void TcpServer::trace(const std::string &message)
+{
+    if ( (this->m_trafficLog != nullptr) && (this->m_trafficLog->isRunning()) ) {
+        this->m_trafficLog->write(message);
+        return;
+    }
+    static std::mutex coutMutex{};
+    std::lock_guard<std::mutex> coutLock{coutMutex};
+    (void)coutLock;
+    std::cout << message << std::endl;
+}
+
+void TcpServer::traceConnection(const std::string &message, const TcpConnection &connection)
+{
+    this->trace(message + " - " + connection.m_peer.toString());
+}
+
+bool TcpServer::isTransientAcceptError(int errorCode)
+{
+    //Linux reports errors already pending on the new connection through accept(), they only concern that connection
+    return (errorCode == EINTR) || (errorCode == ECONNABORTED) || (errorCode == EPROTO) || (errorCode == ENETDOWN) ||
+           (errorCode == ENOPROTOOPT) || (errorCode == EHOSTDOWN) || (errorCode == ENONET) || (errorCode == EHOSTUNREACH) ||
+           (errorCode == EOPNOTSUPP) || (errorCode == ENETUNREACH) || (errorCode == EPERM);
+}
+
+size_t TcpServer::connectionTableSize()
+{
+    //Descriptors index the table, so it never needs to be larger than the descriptor limit
+    rlimit descriptorLimit{};
+    if ( (getrlimit(RLIMIT_NOFILE, &descriptorLimit) == -1) || (descriptorLimit.rlim_cur == RLIM_INFINITY) || (descriptorLimit.rlim_cur > MAXIMUM_CONNECTION_TABLE_SIZE) ) {
+        return MAXIMUM_CONNECTION_TABLE_SIZE;
+    }
+    return static_cast<size_t>(descriptorLimit.rlim_cur);
+}
+
+void TcpServer::setHostName(const std::string &hostName)
+{
+    this->m_hostName = hostName;
+}
+
+void TcpServer::setPortNumber(uint16_t portNumber)
+{
+    this->m_portNumber = portNumber;
+}
+
+void TcpServer::setWorkerCount(int workerCount)
+{
+    if (workerCount < 1) {
+        throw std::runtime_error("CppSerialPort::TcpServer::setWorkerCount(int): workerCount cannot be less than 1 (" + std::to_string(workerCount) + " < 1)");
+    }
+    this->m_workerCount = workerCount;
+}
+
+void TcpServer::setHandlerThreadCount(int handlerThreadCount)
+{
+    if (handlerThreadCount < 0) {
+        throw std::runtime_error("CppSerialPort::TcpServer::setHandlerThreadCount(int): handlerThreadCount cannot be negative (" + std::to_string(handlerThreadCount) + " < 0)");
+    }
+    this->m_handlerThreadCount = handlerThreadCount;
+}
+
+void TcpServer::setIoEngine(IoEngine ioEngine)
+{
+    this->m_ioEngine = ioEngine;
+}
+
+void TcpServer::setWorkerCpus(const std::vector<int> &workerCpus)
+{
+    for (auto cpu : workerCpus) {
+        if ( (cpu < 0) || (cpu >= CPU_SETSIZE) ) {
+            throw std::runtime_error("CppSerialPort::TcpServer::setWorkerCpus(const std::vector<int> &): CPU " + std::to_string(cpu) + " is out of range");
+        }
+    }
+    this->m_workerCpus = workerCpus;
+}
+
+void TcpServer::setIncomingCpuSteering(bool incomingCpuSteering)
+{
+    this->m_incomingCpuSteering = incomingCpuSteering;
+}
+
+void TcpServer::setFramingMode(FramingMode framingMode)
+{
+    this->m_framingMode = framingMode;
+}
+
+void TcpServer::setMaximumFrameSize(size_t maximumFrameSize)
+{
+    this->m_maximumFrameSize = maximumFrameSize;
+}
+
+void TcpServer::setIdleTimeout(std::chrono::milliseconds idleTimeout)
+{
+    this->m_idleTimeout = idleTimeout;
+}
+
+void TcpServer::setReadTimeout(std::chrono::milliseconds readTimeout)
+{
+    this->m_readTimeout = readTimeout;
+}
+
+void TcpServer::setWriteTimeout(std::chrono::milliseconds writeTimeout)
+{
+    this->m_writeTimeout = writeTimeout;
+}
+
+void TcpServer::setListenBacklog(int listenBacklog)
+{
+    this->m_listenBacklog = listenBacklog;
+}
+
+void TcpServer::setDeferAccept(std::chrono::seconds deferAccept)
+{
+    this->m_deferAccept = deferAccept;
+}
+
+void TcpServer::setSocketProfile(SocketTuning::Profile socketProfile)
+{
+    this->m_socketTuning = SocketTuning{socketProfile};
+}
+
+void TcpServer::setZeroCopyThreshold(size_t zeroCopyThreshold)
+{
+    this->m_zeroCopyThreshold = zeroCopyThreshold;
+}
+
+void TcpServer::setMaximumConnections(size_t maximumConnections)
+{
+    this->m_admissionControl.setMaximumConnections(maximumConnections);
+}
+
+void TcpServer::setConnectionRateLimit(double perSecond, double perSourcePerSecond)
+{
+    if ( (perSecond < 0) || (perSourcePerSecond < 0) ) {
+        throw std::runtime_error("CppSerialPort::TcpServer::setConnectionRateLimit(double, double): rates cannot be negative");
+    }
+    this->m_admissionControl.setConnectionRate(perSecond, perSourcePerSecond);
+}
+
+void TcpServer::setMessageRateLimit(double perSecond, double perSourcePerSecond)
+{
+    if ( (perSecond < 0) || (perSourcePerSecond < 0) ) {
+        throw std::runtime_error("CppSerialPort::TcpServer::setMessageRateLimit(double, double): rates cannot be negative");
+    }
+    this->m_admissionControl.setMessageRate(perSecond, perSourcePerSecond);
+}
+
+void TcpServer::setByteRateLimit(double perSecond, double perSourcePerSecond)
+{
+    if ( (perSecond < 0) || (perSourcePerSecond < 0) ) {
+        throw std::runtime_error("CppSerialPort::TcpServer::setByteRateLimit(double, double): rates cannot be negative");
+    }
+    this->m_admissionControl.setByteRate(perSecond, perSourcePerSecond);
+}
+
+void TcpServer::setOverloadResponse(const std::string &overloadResponse)
+{
+    this->m_overloadResponse = overloadResponse;
+}
+
+void TcpServer::setTrafficLog(TrafficLog *trafficLog)
+{
+    this->m_trafficLog = trafficLog;
+}
+
+std::string TcpServer::hostName() const
+{
+    return this->m_hostName;
+}
+
+uint16_t TcpServer::portNumber() const
+{
+    return this->m_portNumber;
+}
+
+int TcpServer::workerCount() const
+{
+    return this->m_workerCount;
+}
+
+int TcpServer::handlerThreadCount() const
+{
+    return this->m_handlerThreadCount;
+}
+
+TcpServer::IoEngine TcpServer::ioEngine() const
+{
+    return this->m_ioEngine;
+}
+
+std::vector<int> TcpServer::workerCpus() const
+{
+    return this->m_workerCpus;
+}
+
+bool TcpServer::incomingCpuSteering() const
+{
+    return this->m_incomingCpuSteering;
+}
+
+FramingMode TcpServer::framingMode() const
+{
+    return this->m_framingMode;
+}
+
+size_t TcpServer::maximumFrameSize() const
+{
+    return this->m_maximumFrameSize;
+}
+
+std::chrono::milliseconds TcpServer::idleTimeout() const
+{
+    return this->m_idleTimeout;
+}
+
+std::chrono::milliseconds TcpServer::readTimeout() const
+{
+    return this->m_readTimeout;
+}
+
+std::chrono::milliseconds TcpServer::writeTimeout() const
+{
+    return this->m_writeTimeout;
+}
+
+int TcpServer::listenBacklog() const
+{
+    return this->m_listenBacklog;
+}
+
+std::chrono::seconds TcpServer::deferAccept() const
+{
+    return this->m_deferAccept;
+}
+
+SocketTuning::Profile TcpServer::socketProfile() const
+{
+    return this->m_socketTuning.profile();
+}
+
+size_t TcpServer::zeroCopyThreshold() const
+{
+    return this->m_zeroCopyThreshold;
+}
+
+size_t TcpServer::maximumConnections() const
+{
+    return this->m_admissionControl.maximumConnections();
+}
+
+std::string TcpServer::overloadResponse() const
+{
+    return this->m_overloadResponse;
+}
+
+uint64_t TcpServer::rejectedConnectionCount() const
+{
+    return this->m_admissionControl.rejectedConnections();
+}
+
+uint64_t TcpServer::rejectedMessageCount() const
+{
+    return this->m_admissionControl.rejectedMessages();
+}
+
+} //namespace CppSerialPort
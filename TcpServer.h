@@ -0,0 +1,267 @@
+#ifndef CPPSERIALPORT_TCPSERVER_H
+#define CPPSERIALPORT_TCPSERVER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/socket.h>
+#include <netdb.h>
+
+#include "ConnectionTable.h"
+#include "TimerWheel.h"
+#include "PeerAddress.h"
+#include "FrameDecoder.h"
+#include "OutputQueue.h"
+#include "TrafficLog.h"
+#include "WorkStealingExecutor.h"
+#include "SocketTuning.h"
+#include "AdmissionControl.h"
+#include "BufferPool.h"
+
+namespace CppSerialPort {
+
+/*
+ * One accepted connection, as handed to an ITcpServerHandler. A connection is
+ * only ever touched by the reactor thread that accepted it, and by at most one
+ * handler thread at a time, so the handler never needs to lock it
+ */
+class TcpConnection
+{
+public:
+    TcpConnection(int socketDescriptor, const PeerAddress &peer, FramingMode framingMode, size_t maximumFrameSize);
+    TcpConnection(const TcpConnection &) = delete;
+    TcpConnection &operator=(const TcpConnection &) = delete;
+
+    int socketDescriptor() const;
+    const PeerAddress &peer() const;
+
+    //Queued responses go out in one gathered send after the handler returns
+    //(from a handler thread, once the reactor thread has picked them up)
+    //Data must outlive the connection
+    void sendStatic(const char *data, size_t length);
+    //Data must stay valid until the handler returns (frames passed to onFrame() do)
+    void sendBorrowed(const char *data, size_t length);
+    void send(const char *data, size_t length);
+    void send(const std::string &data);
+    //Streams length bytes of the file from offset with sendfile(), without copying them through user space.
+    //Takes ownership of fileDescriptor. SIGPIPE must be ignored or handled, sendfile() cannot suppress it
+    void sendFile(int fileDescriptor, off_t offset, size_t length);
+    size_t queuedBytes() const;
+
+    //The connection is closed once the handler returns, after one attempt to send what is queued
+    void close();
+    bool isClosing() const;
+
+    //Per-connection protocol state, released with the connection
+    void setContext(const std::shared_ptr<void> &context);
+    const std::shared_ptr<void> &context() const;
+
+private:
+    friend class TcpServer;
+    //A rejected frame only holds its place in line, so the overload response follows the responses before it
+    struct StrandFrame
+    {
+        std::string data;
+        bool rejected;
+    };
+
+    int m_socketDescriptor;
+    PeerAddress m_peer;
+    FrameDecoder m_frameDecoder;
+    OutputQueue m_outputQueue;
+    //Set while the peer is not reading its responses fast enough
+    bool m_readPaused;
+    bool m_closeRequested;
+    //Set once onClose() is dispatched. With handler threads the descriptor stays open until it has returned
+    bool m_closeDispatched;
+    Timer m_idleTimer;
+    Timer m_readTimer;
+    Timer m_writeTimer;
+    std::shared_ptr<void> m_context;
+    //Per source rate limits, null unless the server sets any
+    std::shared_ptr<AdmissionControl::Source> m_admissionSource;
+    //How much the epoll engine reads at a time, grows for bulk flows and shrinks back once they go quiet
+    size_t m_receiveSize;
+    //Frames waiting for a handler thread. At most one strand task per connection is queued
+    //or running, which keeps frames, and the responses to them, in order
+    std::mutex m_strandMutex;
+    std::deque<StrandFrame> m_strandFrames;
+    bool m_strandScheduled;
+    bool m_strandClosed;
+    //Only touched by the strand task that currently owns the connection
+    OutputQueue m_strandOutput;
+    bool m_strandCloseRequested;
+    //Handed to a handler thread and not answered yet, counted against the output high-water mark
+    size_t m_offloadedBytes;
+
+    OutputQueue &activeOutputQueue();
+};
+
+/*
+ * Protocol logic plugged into a TcpServer. Calls for one connection never
+ * overlap and arrive in order, but calls for different connections run
+ * concurrently with several workers or handler threads. onConnect() always
+ * runs on the reactor thread, onFrame() and onClose() run on a handler thread
+ * when the server has any
+ */
+class ITcpServerHandler
+{
+public:
+    virtual ~ITcpServerHandler() = default;
+    virtual void onConnect(TcpConnection &connection) = 0;
+    //frame holds one complete frame without its delimiter or length prefix, and is only valid until onFrame() returns
+    virtual void onFrame(TcpConnection &connection, const char *frame, size_t length) = 0;
+    //Called once per connection, before its descriptor is closed
+    virtual void onClose(TcpConnection &connection) = 0;
+};
+
+/*
+ * Multi-reactor TCP server. Every worker thread runs its own event loop
+ * (epoll, or io_uring where available) with its own SO_REUSEPORT listener,
+ * frames incoming bytes with a FrameDecoder and passes each frame to the
+ * handler. Output is bounded per connection, and idle, read and write
+ * deadlines run on each reactor's timer wheel
+ */
+class TcpServer
+{
+public:
+    enum class IoEngine {
+        Epoll,
+        IoUring
+    };
+
+    TcpServer(const std::string &hostName, uint16_t portNumber, ITcpServerHandler *handler);
+    ~TcpServer();
+    TcpServer(const TcpServer &) = delete;
+    TcpServer &operator=(const TcpServer &) = delete;
+
+    //Binds every listener, runs the first reactor on the calling thread, and returns once stop() is called
+    void run();
+    //Safe to call from any thread, or from a signal handler
+    void stop();
+    bool isRunning() const;
+    size_t connectionCount() const;
+
+    void setHostName(const std::string &hostName);
+    void setPortNumber(uint16_t portNumber);
+    void setWorkerCount(int workerCount);
+    //Frames are handed to this many work-stealing handler threads, 0 runs the handler on the reactor threads
+    void setHandlerThreadCount(int handlerThreadCount);
+    void setIoEngine(IoEngine ioEngine);
+    //Worker i runs pinned to workerCpus[i % size], with its memory on that CPU's NUMA node.
+    //Empty (the default) leaves the workers to the scheduler
+    void setWorkerCpus(const std::vector<int> &workerCpus);
+    //Each pinned worker's listener asks for the connections whose packets arrive on its CPU (SO_INCOMING_CPU)
+    void setIncomingCpuSteering(bool incomingCpuSteering);
+    void setFramingMode(FramingMode framingMode);
+    void setMaximumFrameSize(size_t maximumFrameSize);
+    //A zero timeout disables that deadline
+    void setIdleTimeout(std::chrono::milliseconds idleTimeout);
+    void setReadTimeout(std::chrono::milliseconds readTimeout);
+    void setWriteTimeout(std::chrono::milliseconds writeTimeout);
+    void setListenBacklog(int listenBacklog);
+    void setDeferAccept(std::chrono::seconds deferAccept);
+    //Applied to every listener before listen(), accepted connections inherit it
+    void setSocketProfile(SocketTuning::Profile socketProfile);
+    //Output sends of at least this many bytes use MSG_ZEROCOPY where the kernel supports it, 0 always copies.
+    //Only the epoll engine sends this way
+    void setZeroCopyThreshold(size_t zeroCopyThreshold);
+    //Overload protection, all off by default. Rejected connections get the overload response, if the socket
+    //buffer takes it straight away, and are closed. Rejected frames are answered with it and dropped
+    void setMaximumConnections(size_t maximumConnections);
+    //Server wide budgets are split evenly between the workers. 0 leaves a limit off
+    void setConnectionRateLimit(double perSecond, double perSourcePerSecond);
+    void setMessageRateLimit(double perSecond, double perSourcePerSecond);
+    void setByteRateLimit(double perSecond, double perSourcePerSecond);
+    //Sent as is, so it must already be framed. Empty rejects silently
+    void setOverloadResponse(const std::string &overloadResponse);
+    //Connection events and errors are traced here, or to stdout if no running log is set
+    void setTrafficLog(TrafficLog *trafficLog);
+
+    std::string hostName() const;
+    uint16_t portNumber() const;
+    int workerCount() const;
+    int handlerThreadCount() const;
+    IoEngine ioEngine() const;
+    std::vector<int> workerCpus() const;
+    bool incomingCpuSteering() const;
+    FramingMode framingMode() const;
+    size_t maximumFrameSize() const;
+    std::chrono::milliseconds idleTimeout() const;
+    std::chrono::milliseconds readTimeout() const;
+    std::chrono::milliseconds writeTimeout() const;
+    int listenBacklog() const;
+    std::chrono::seconds deferAccept() const;
+    SocketTuning::Profile socketProfile() const;
+    size_t zeroCopyThreshold() const;
+    size_t maximumConnections() const;
+    std::string overloadResponse() const;
+    uint64_t rejectedConnectionCount() const;
+    uint64_t rejectedMessageCount() const;
+
+    static const std::chrono::milliseconds DEFAULT_IDLE_TIMEOUT;
+    static const std::chrono::milliseconds DEFAULT_READ_TIMEOUT;
+    static const std::chrono::milliseconds DEFAULT_WRITE_TIMEOUT;
+    //Reading from a peer stops once this much output is waiting for it, and resumes below the low mark
+    static const size_t OUTPUT_HIGH_WATER_MARK;
+    static const size_t OUTPUT_LOW_WATER_MARK;
+
+private:
+    class Reactor;
+
+    std::string m_hostName;
+    uint16_t m_portNumber;
+    ITcpServerHandler *m_handler;
+    int m_workerCount;
+    int m_handlerThreadCount;
+    IoEngine m_ioEngine;
+    std::vector<int> m_workerCpus;
+    bool m_incomingCpuSteering;
+    FramingMode m_framingMode;
+    size_t m_maximumFrameSize;
+    std::chrono::milliseconds m_idleTimeout;
+    std::chrono::milliseconds m_readTimeout;
+    std::chrono::milliseconds m_writeTimeout;
+    int m_listenBacklog;
+    std::chrono::seconds m_deferAccept;
+    SocketTuning m_socketTuning;
+    size_t m_zeroCopyThreshold;
+    AdmissionControl m_admissionControl;
+    std::string m_overloadResponse;
+    TrafficLog *m_trafficLog;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopRequested;
+    //Keyed by accepted socket descriptor, shared by every reactor
+    std::unique_ptr<ConnectionTable<TcpConnection>> m_connections;
+    std::vector<std::unique_ptr<Reactor>> m_reactors;
+    std::unique_ptr<WorkStealingExecutor> m_executor;
+
+    int createListenSocket(const addrinfo *listenAddress, bool reusePort);
+    void closeRemainingConnections();
+    void tuneAcceptedConnection(int socketDescriptor);
+
+    bool flushConnection(TcpConnection &connection);
+    bool pauseReadingIfBacklogged(TcpConnection &connection);
+    bool resumeReadingIfDrained(TcpConnection &connection);
+    void setConnectionTimeouts(TcpConnection &connection, const std::function<void(const std::string &)> &expire);
+    void updateConnectionTimers(TimerWheel &timerWheel, TcpConnection &connection, bool received, bool sent);
+    void cancelConnectionTimers(TcpConnection &connection);
+
+    void trace(const std::string &message);
+    void traceConnection(const std::string &message, const TcpConnection &connection);
+
+    static bool isTransientAcceptError(int errorCode);
+    static size_t connectionTableSize();
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_TCPSERVER_H
@@ -0,0 +1,205 @@
+#include "TimerWheel.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace CppSerialPort {
+
+const std::chrono::milliseconds TimerWheel::DEFAULT_TICK_INTERVAL{100};
+const size_t TimerWheel::DEFAULT_SLOT_COUNT{512};
+
+TimerLink::TimerLink() :
+    m_next{nullptr},
+    m_previous{nullptr}
+{
+
+}
+
+void TimerLink::linkBefore(TimerLink *link)
+{
+    this->m_next = link;
+    this->m_previous = link->m_previous;
+    link->m_previous->m_next = this;
+    link->m_previous = this;
+}
+
+void TimerLink::unlink()
+{
+    this->m_previous->m_next = this->m_next;
+    this->m_next->m_previous = this->m_previous;
+    this->m_next = nullptr;
+    this->m_previous = nullptr;
+}
+
+Timer::Timer(const std::function<void()> &callback) :
+    TimerLink{},
+    m_wheel{nullptr},
+    m_expiryTick{0},
+    m_callback{callback}
+{
+
+}
+
+Timer::~Timer()
+{
+    this->cancel();
+}
+
+void Timer::setCallback(const std::function<void()> &callback)
+{
+    this->m_callback = callback;
+}
+
+void Timer::cancel()
+{
+    if (this->m_wheel != nullptr) {
+        this->m_wheel->cancel(*this);
+    }
+}
+
+bool Timer::isScheduled() const
+{
+    return (this->m_wheel != nullptr);
+}
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tickInterval, size_t slotCount) :
+    m_tickInterval{tickInterval},
+    m_slotCount{slotCount},
+    m_slots{},
+    m_startTime{std::chrono::steady_clock::now()},
+    m_currentTick{0},
+    m_size{0}
+{
+    if ( (tickInterval.count() <= 0) || (slotCount == 0) ) {
+        throw std::runtime_error("CppSerialPort::TimerWheel::TimerWheel(std::chrono::milliseconds, size_t): invariant failure (tick interval and slot count must be positive)");
+    }
+    //Each slot is the sentinel of a circular list, so an empty slot points at itself
+    this->m_slots.reset(new TimerLink[slotCount]);
+    for (size_t i = 0; i < slotCount; i++) {
+        this->m_slots[i].m_next = &this->m_slots[i];
+        this->m_slots[i].m_previous = &this->m_slots[i];
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    for (size_t i = 0; i < this->m_slotCount; i++) {
+        auto &slot = this->m_slots[i];
+        while (slot.m_next != &slot) {
+            auto timer = static_cast<Timer *>(slot.m_next);
+            timer->unlink();
+            timer->m_wheel = nullptr;
+        }
+    }
+}
+
+uint64_t TimerWheel::tickAt(std::chrono::steady_clock::time_point timePoint) const
+{
+    if (timePoint <= this->m_startTime) {
+        return 0;
+    }
+    return static_cast<uint64_t>((timePoint - this->m_startTime) / this->m_tickInterval);
+}
+
+void TimerWheel::schedule(Timer &timer, std::chrono::milliseconds delay)
+{
+    if (timer.m_wheel != nullptr) {
+        timer.m_wheel->cancel(timer);
+    }
+    //Round up, so a timer never fires before its delay has passed
+    auto expiryTime = std::chrono::steady_clock::now() + delay - this->m_startTime;
+    auto expiryTick = static_cast<uint64_t>((expiryTime + this->m_tickInterval - std::chrono::nanoseconds{1}) / this->m_tickInterval);
+    timer.m_expiryTick = std::max(expiryTick, this->m_currentTick + 1);
+    this->insert(timer);
+}
+
+void TimerWheel::insert(Timer &timer)
+{
+    timer.linkBefore(&this->m_slots[timer.m_expiryTick % this->m_slotCount]);
+    timer.m_wheel = this;
+    this->m_size++;
+}
+
+void TimerWheel::cancel(Timer &timer)
+{
+    if (timer.m_wheel != this) {
+        return;
+    }
+    timer.unlink();
+    timer.m_wheel = nullptr;
+    this->m_size--;
+}
+
+size_t TimerWheel::advance(std::chrono::steady_clock::time_point now)
+{
+    auto targetTick = this->tickAt(now);
+    if (targetTick <= this->m_currentTick) {
+        return 0;
+    }
+    //Expired timers move to a local list first, since callbacks may reschedule into the slots being walked
+    TimerLink expired{};
+    expired.m_next = &expired;
+    expired.m_previous = &expired;
+    auto slotsToVisit = std::min<uint64_t>(targetTick - this->m_currentTick, this->m_slotCount);
+    for (uint64_t i = 1; i <= slotsToVisit; i++) {
+        auto &slot = this->m_slots[(this->m_currentTick + i) % this->m_slotCount];
+        for (auto link = slot.m_next; link != &slot; ) {
+            auto next = link->m_next;
+            //Timers for a later revolution stay where they are
+            if (static_cast<Timer *>(link)->m_expiryTick <= targetTick) {
+                link->unlink();
+                link->linkBefore(&expired);
+            }
+            link = next;
+        }
+    }
+    this->m_currentTick = targetTick;
+    size_t fired{0};
+    while (expired.m_next != &expired) {
+        auto timer = static_cast<Timer *>(expired.m_next);
+        this->cancel(*timer);
+        //The callback may destroy the timer, and its own std::function with it
+        auto callback = timer->m_callback;
+        if (callback) {
+            callback();
+        }
+        fired++;
+    }
+    return fired;
+}
+
+int TimerWheel::millisecondsUntilNextTick(std::chrono::steady_clock::time_point now) const
+{
+    if (this->m_size == 0) {
+        return -1;
+    }
+    auto nextTickTime = this->m_startTime + (this->m_tickInterval * static_cast<int64_t>(this->m_currentTick + 1));
+    if (nextTickTime <= now) {
+        return 0;
+    }
+    //Round up, so the wait never ends just short of the tick
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(nextTickTime - now + std::chrono::milliseconds{1} - std::chrono::nanoseconds{1});
+    return static_cast<int>(remaining.count());
+}
+
+size_t TimerWheel::size() const
+{
+    return this->m_size;
+}
+
+bool TimerWheel::empty() const
+{
+    return (this->m_size == 0);
+}
+
+std::chrono::milliseconds TimerWheel::tickInterval() const
+{
+    return this->m_tickInterval;
+}
+
+size_t TimerWheel::slotCount() const
+{
+    return this->m_slotCount;
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,101 @@
+#ifndef CPPSERIALPORT_TIMERWHEEL_H
+#define CPPSERIALPORT_TIMERWHEEL_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+class TimerWheel;
+
+/*
+ * Intrusive list node, so scheduling and cancelling a timer never allocates
+ * and never has to know which slot the timer is in
+ */
+class TimerLink
+{
+public:
+    TimerLink();
+    TimerLink(const TimerLink &) = delete;
+    TimerLink &operator=(const TimerLink &) = delete;
+
+protected:
+    friend class TimerWheel;
+    TimerLink *m_next;
+    TimerLink *m_previous;
+
+    void linkBefore(TimerLink *link);
+    void unlink();
+};
+
+/*
+ * One-shot timer owned by the caller (usually a member of whatever it times
+ * out). The callback may schedule, cancel or destroy the timer itself
+ */
+class Timer : public TimerLink
+{
+public:
+    explicit Timer(const std::function<void()> &callback = std::function<void()>{});
+    ~Timer();
+
+    void setCallback(const std::function<void()> &callback);
+    void cancel();
+    bool isScheduled() const;
+
+private:
+    friend class TimerWheel;
+    TimerWheel *m_wheel;
+    uint64_t m_expiryTick;
+    std::function<void()> m_callback;
+};
+
+/*
+ * Hashed timing wheel. A timer lands in slot (expiry tick % slot count) and
+ * waits out any whole revolutions there, so schedule() and cancel() are O(1)
+ * whatever the delay, and advance() only visits the slots that came due.
+ * Timers fire at tick granularity, never early. Not thread-safe, it belongs
+ * to the thread running the event loop
+ */
+class TimerWheel
+{
+public:
+    explicit TimerWheel(std::chrono::milliseconds tickInterval = DEFAULT_TICK_INTERVAL, size_t slotCount = DEFAULT_SLOT_COUNT);
+    ~TimerWheel();
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    //Reschedules the timer if it is already scheduled
+    void schedule(Timer &timer, std::chrono::milliseconds delay);
+    void cancel(Timer &timer);
+
+    //Fires every timer that expired by now, returning how many fired
+    size_t advance(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    //Suitable as an epoll_wait() timeout, -1 when nothing is scheduled
+    int millisecondsUntilNextTick(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const;
+
+    size_t size() const;
+    bool empty() const;
+    std::chrono::milliseconds tickInterval() const;
+    size_t slotCount() const;
+
+    static const std::chrono::milliseconds DEFAULT_TICK_INTERVAL;
+    static const size_t DEFAULT_SLOT_COUNT;
+
+private:
+    std::chrono::milliseconds m_tickInterval;
+    size_t m_slotCount;
+    std::unique_ptr<TimerLink[]> m_slots;
+    std::chrono::steady_clock::time_point m_startTime;
+    uint64_t m_currentTick;
+    size_t m_size;
+
+    uint64_t tickAt(std::chrono::steady_clock::time_point timePoint) const;
+    void insert(Timer &timer);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_TIMERWHEEL_H
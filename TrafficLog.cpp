@@ -0,0 +1,219 @@
+#include "TrafficLog.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+
+namespace CppSerialPort {
+
+const size_t TrafficLog::DEFAULT_THREAD_BUFFER_SIZE{1 << 20};
+const size_t TrafficLog::MAXIMUM_BATCH_SIZE{1 << 16};
+
+namespace {
+    //The rings this thread writes to, one per log. lifetime expires with the log that owns the ring
+    struct ThreadBufferEntry
+    {
+        uint64_t logId;
+        void *buffer;
+        std::weak_ptr<void> lifetime;
+    };
+    thread_local std::vector<ThreadBufferEntry> threadBufferEntries{};
+    std::atomic<uint64_t> nextLogId{1};
+
+    size_t roundUpToPowerOfTwo(size_t value) {
+        size_t returnValue{64};
+        while (returnValue < value) {
+            returnValue <<= 1;
+        }
+        return returnValue;
+    }
+} //Global namespace
+
+TrafficLog::ThreadBuffer::ThreadBuffer(size_t bufferCapacity) :
+    data{new char[bufferCapacity]},
+    capacity{bufferCapacity},
+    head{0},
+    padding{},
+    tail{0}
+{
+
+}
+
+TrafficLog::TrafficLog(int outputDescriptor, size_t threadBufferSize) :
+    m_id{nextLogId.fetch_add(1, std::memory_order_relaxed)},
+    m_outputDescriptor{outputDescriptor},
+    m_threadBufferSize{roundUpToPowerOfTwo(threadBufferSize)},
+    m_running{false},
+    m_droppedCount{0},
+    m_reportedDroppedCount{0},
+    m_writerThread{},
+    m_registrationMutex{},
+    m_threadBuffers{}
+{
+
+}
+
+TrafficLog::~TrafficLog()
+{
+    this->stop();
+}
+
+void TrafficLog::start()
+{
+    if (this->m_running.exchange(true)) {
+        return;
+    }
+    this->m_writerThread = std::thread{&TrafficLog::writerLoop, this};
+}
+
+void TrafficLog::stop()
+{
+    if (!this->m_running.exchange(false)) {
+        return;
+    }
+    if (this->m_writerThread.joinable()) {
+        this->m_writerThread.join();
+    }
+}
+
+bool TrafficLog::isRunning() const
+{
+    return this->m_running;
+}
+
+uint64_t TrafficLog::droppedCount() const
+{
+    return this->m_droppedCount;
+}
+
+TrafficLog::ThreadBuffer *TrafficLog::threadBuffer()
+{
+    for (const auto &it : threadBufferEntries) {
+        if (it.logId == this->m_id) {
+            return static_cast<ThreadBuffer *>(it.buffer);
+        }
+    }
+    //Entries of destroyed logs go here, so a long lived thread does not collect them
+    threadBufferEntries.erase(std::remove_if(threadBufferEntries.begin(), threadBufferEntries.end(), [](const ThreadBufferEntry &entry) {
+        return entry.lifetime.expired();
+    }), threadBufferEntries.end());
+    //Registration is the only locked operation, and happens once per producing thread and log
+    std::shared_ptr<ThreadBuffer> buffer{new ThreadBuffer{this->m_threadBufferSize}};
+    {
+        std::lock_guard<std::mutex> registrationLock{this->m_registrationMutex};
+        (void)registrationLock;
+        this->m_threadBuffers.push_back(buffer);
+    }
+    threadBufferEntries.push_back(ThreadBufferEntry{this->m_id, buffer.get(), buffer});
+    return buffer.get();
+}
+
+bool TrafficLog::write(const std::string &line)
+{
+    return this->write(line.data(), line.length());
+}
+
+bool TrafficLog::write(const char *line, size_t length)
+{
+    auto buffer = this->threadBuffer();
+    auto recordLength = static_cast<uint32_t>(length);
+    auto recordSize = sizeof(recordLength) + length;
+    auto tail = buffer->tail.load(std::memory_order_relaxed);
+    auto head = buffer->head.load(std::memory_order_acquire);
+    if ( (recordSize > buffer->capacity) || ((buffer->capacity - (tail - head)) < recordSize) ) {
+        this->m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    auto mask = buffer->capacity - 1;
+    auto copyIn = [buffer, mask](size_t position, const char *source, size_t count) {
+        auto offset = position & mask;
+        auto firstPart = (count < (buffer->capacity - offset)) ? count : (buffer->capacity - offset);
+        memcpy(buffer->data.get() + offset, source, firstPart);
+        memcpy(buffer->data.get(), source + firstPart, count - firstPart);
+    };
+    copyIn(tail, reinterpret_cast<const char *>(&recordLength), sizeof(recordLength));
+    copyIn(tail + sizeof(recordLength), line, length);
+    buffer->tail.store(tail + recordSize, std::memory_order_release);
+    return true;
+}
+
+bool TrafficLog::drainThreadBuffers(std::string &batch)
+{
+    std::lock_guard<std::mutex> registrationLock{this->m_registrationMutex};
+    (void)registrationLock;
+    bool moreAvailable{false};
+    for (auto &buffer : this->m_threadBuffers) {
+        auto mask = buffer->capacity - 1;
+        auto copyOut = [&buffer, mask](size_t position, char *destination, size_t count) {
+            auto offset = position & mask;
+            auto firstPart = (count < (buffer->capacity - offset)) ? count : (buffer->capacity - offset);
+            memcpy(destination, buffer->data.get() + offset, firstPart);
+            memcpy(destination + firstPart, buffer->data.get(), count - firstPart);
+        };
+        auto head = buffer->head.load(std::memory_order_relaxed);
+        auto tail = buffer->tail.load(std::memory_order_acquire);
+        while ( (head != tail) && (batch.length() < MAXIMUM_BATCH_SIZE) ) {
+            uint32_t recordLength{0};
+            copyOut(head, reinterpret_cast<char *>(&recordLength), sizeof(recordLength));
+            auto batchLength = batch.length();
+            batch.resize(batchLength + recordLength + 1);
+            copyOut(head + sizeof(recordLength), &batch[batchLength], recordLength);
+            batch.back() = '\n';
+            head += sizeof(recordLength) + recordLength;
+        }
+        buffer->head.store(head, std::memory_order_release);
+        if (head != tail) {
+            moreAvailable = true;
+        }
+    }
+    return moreAvailable;
+}
+
+void TrafficLog::writeBatch(const std::string &batch)
+{
+    size_t written{0};
+    while (written < batch.length()) {
+        auto writeResult = ::write(this->m_outputDescriptor, batch.data() + written, batch.length() - written);
+        if (writeResult == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        written += static_cast<size_t>(writeResult);
+    }
+}
+
+void TrafficLog::writerLoop()
+{
+    std::string batch{};
+    batch.reserve(MAXIMUM_BATCH_SIZE * 2);
+    while (true) {
+        //Read the flag first, so nothing logged before stop() is left behind
+        bool running{this->m_running};
+        batch.clear();
+        auto moreAvailable = this->drainThreadBuffers(batch);
+        auto droppedCount = this->m_droppedCount.load(std::memory_order_relaxed);
+        if (droppedCount != this->m_reportedDroppedCount) {
+            batch += "TrafficLog: " + std::to_string(droppedCount - this->m_reportedDroppedCount) + " line(s) dropped\n";
+            this->m_reportedDroppedCount = droppedCount;
+        }
+        if (!batch.empty()) {
+            this->writeBatch(batch);
+        }
+        if (moreAvailable) {
+            continue;
+        }
+        if (!running) {
+            return;
+        }
+        if (batch.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+} //namespace CppSerialPort
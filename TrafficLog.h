@@ -0,0 +1,72 @@
+#ifndef CPPSERIALPORT_TRAFFICLOG_H
+#define CPPSERIALPORT_TRAFFICLOG_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+/*
+ * Asynchronous line log for the data path. Every producing thread gets its own
+ * lock-free single producer/single consumer ring, and one writer thread drains
+ * all of them into large batched write() calls with no per-line flush. When a
+ * ring is full the line is dropped and counted rather than blocking the producer
+ */
+class TrafficLog
+{
+public:
+    explicit TrafficLog(int outputDescriptor, size_t threadBufferSize = DEFAULT_THREAD_BUFFER_SIZE);
+    ~TrafficLog();
+    TrafficLog(const TrafficLog &) = delete;
+    TrafficLog &operator=(const TrafficLog &) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    bool write(const char *line, size_t length);
+    bool write(const std::string &line);
+    uint64_t droppedCount() const;
+
+    static const size_t DEFAULT_THREAD_BUFFER_SIZE;
+
+private:
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer(size_t bufferCapacity);
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+        std::atomic<size_t> head;
+        //Keeps the consumer and producer cursors on separate cache lines
+        char padding[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> tail;
+    };
+
+    //Unique for the life of the process, so a log built where an old one stood is never mistaken for it
+    uint64_t m_id;
+    int m_outputDescriptor;
+    size_t m_threadBufferSize;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_droppedCount;
+    uint64_t m_reportedDroppedCount;
+    std::thread m_writerThread;
+    std::mutex m_registrationMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_threadBuffers;
+
+    ThreadBuffer *threadBuffer();
+    void writerLoop();
+    bool drainThreadBuffers(std::string &batch);
+    void writeBatch(const std::string &batch);
+
+    static const size_t MAXIMUM_BATCH_SIZE;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_TRAFFICLOG_H
@@ -0,0 +1,343 @@
+#include "UdpClient.h"
+
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <iostream>
+
+#include <unistd.h>
+#include <poll.h>
+
+namespace CppSerialPort {
+
+#define MINIMUM_PORT_NUMBER 1024
+
+const size_t UdpClient::DEFAULT_BATCH_SIZE{64};
+
+UdpClient::UdpClient(const std::string &hostName, uint16_t portNumber) :
+    m_socketDescriptor{-1},
+    m_portNumber{portNumber},
+    m_hostName{hostName},
+    m_readBuffer{""},
+    m_readOffset{0},
+    m_batchSize{DEFAULT_BATCH_SIZE},
+    m_offloadEnabled{false},
+    m_receiveBatch{nullptr},
+    m_sendBatch{nullptr}
+{
+    if (portNumber < MINIMUM_PORT_NUMBER) {
+        this->m_portNumber = 0;
+        throw std::runtime_error("CppSerialPort::UdpClient::UdpClient(const std::string &, uint16_t): portNumber cannot be less than minimum value (" + toStdString(portNumber) + " < " + toStdString(MINIMUM_PORT_NUMBER) + ')');
+    }
+    this->setReadTimeout(DEFAULT_READ_TIMEOUT);
+}
+
+UdpClient::~UdpClient()
+{
+    if (this->isConnected()) {
+        this->disconnect();
+    }
+}
+
+std::string UdpClient::getErrorString(int errorCode)
+{
+    char errorString[PATH_MAX];
+    memset(errorString, '\0', PATH_MAX);
+    auto strerrorCode = strerror_r(errorCode, errorString, PATH_MAX);
+    if (strerrorCode == nullptr) {
+        std::cerr << "strerror_r(int, char *, int): error occurred" << std::endl;
+        return "";
+    }
+    return stripLineEndings(strerrorCode);
+}
+
+void UdpClient::connect(const std::string &hostName, uint16_t portNumber)
+{
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(const std::string &, uint16_t): Cannot connect to new host when already connected (call disconnect() first)");
+    }
+    this->m_hostName = hostName;
+    this->m_portNumber = portNumber;
+    this->connect();
+}
+
+void UdpClient::connect()
+{
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(): Cannot connect to new host when already connected (call disconnect() first)");
+    }
+    addrinfo *addressInfo{nullptr};
+    addrinfo hints{};
+    memset(reinterpret_cast<void *>(&hints), 0, sizeof(addrinfo));
+    hints.ai_family = AF_UNSPEC; //IPV4 or IPV6
+    hints.ai_socktype = SOCK_DGRAM; //UDP
+    auto returnStatus = getaddrinfo(
+            this->m_hostName.c_str(), //IP Address or hostname
+            toStdString(this->m_portNumber).c_str(), //Service (HTTP, port, etc)
+            &hints, //Use the hints specified above
+            &addressInfo //Pointer to linked list to be filled in by getaddrinfo
+    );
+    if (returnStatus != 0) {
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(): getaddrinfo(const char *, const char *, constr addrinfo *, addrinfo **): error code " + toStdString(returnStatus) + " (" + gai_strerror(returnStatus) + ')');
+    }
+    auto socketDescriptor = socket(addressInfo->ai_family, addressInfo->ai_socktype, addressInfo->ai_protocol);
+    if (socketDescriptor == -1) {
+        auto errorCode = errno;
+        freeaddrinfo(addressInfo);
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(): socket(int, int, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    //A connected datagram socket only accepts datagrams from the server, and needs no address per send
+    auto connectResult = ::connect(socketDescriptor, addressInfo->ai_addr, addressInfo->ai_addrlen);
+    if (connectResult == -1) {
+        auto errorCode = errno;
+        freeaddrinfo(addressInfo);
+        close(socketDescriptor);
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(): connect(int, const sockaddr *addr, socklen_t): error code " + toStdString(errorCode) +  " (" + getErrorString(errorCode) + ')');
+    }
+    freeaddrinfo(addressInfo);
+    this->m_socketDescriptor = socketDescriptor;
+    this->m_readBuffer.clear();
+    this->m_readOffset = 0;
+
+    timeval tv{};
+    tv.tv_sec = static_cast<long>(this->writeTimeout() / 1000);
+    tv.tv_usec = static_cast<long>((this->writeTimeout() % 1000) * 1000);
+    auto writeTimeoutResult = setsockopt(this->m_socketDescriptor, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (writeTimeoutResult == -1) {
+        auto errorCode = errno;
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(): setsockopt(int, int, int, const void *, int) set write timeout failed: error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    if ( (this->m_offloadEnabled) && (!DatagramReceiveBatch::enableReceiveOffload(this->m_socketDescriptor)) ) {
+        auto errorCode = errno;
+        throw std::runtime_error("CppSerialPort::UdpClient::connect(): setsockopt(int, int, int, const void *, int) UDP_GRO: error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    this->createBatches();
+}
+
+void UdpClient::createBatches()
+{
+    this->m_receiveBatch.reset(new DatagramReceiveBatch{this->m_batchSize});
+    this->m_sendBatch.reset(new DatagramSendBatch{this->m_batchSize, this->m_offloadEnabled});
+}
+
+bool UdpClient::disconnect()
+{
+    close(this->m_socketDescriptor);
+    this->m_socketDescriptor = -1;
+    return true;
+}
+
+bool UdpClient::isConnected() const
+{
+    return this->m_socketDescriptor != -1;
+}
+
+bool UdpClient::waitForReadable(int timeout)
+{
+    pollfd pollDescriptor{this->m_socketDescriptor, POLLIN, 0};
+    auto pollResult = poll(&pollDescriptor, 1, timeout);
+    if (pollResult == -1) {
+        auto errorCode = errno;
+        if (errorCode == EINTR) {
+            return false;
+        }
+        throw std::runtime_error("CppSerialPort::UdpClient::waitForReadable(int): poll(pollfd *, nfds_t, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    return (pollResult == 1);
+}
+
+char UdpClient::read()
+{
+    if (this->m_readOffset >= this->m_readBuffer.length()) {
+        this->m_readBuffer.clear();
+        this->m_readOffset = 0;
+        for (const auto &it : this->readDatagrams()) {
+            this->m_readBuffer += it;
+        }
+        if (this->m_readBuffer.empty()) {
+            return 0;
+        }
+    }
+    return this->m_readBuffer[this->m_readOffset++];
+}
+
+std::vector<std::string> UdpClient::readDatagrams()
+{
+    if (!this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::readDatagrams(): Cannot read on closed socket (call connect first)");
+    }
+    std::vector<std::string> returnValue{};
+    if (!this->waitForReadable(this->readTimeout())) {
+        return returnValue;
+    }
+    auto &receiveBatch = *this->m_receiveBatch;
+    auto receiveResult = receiveBatch.receive(this->m_socketDescriptor, MSG_DONTWAIT);
+    if (receiveResult == -1) {
+        auto errorCode = errno;
+        //A refused earlier datagram (no server listening yet) is reported here, and is not fatal for UDP
+        if ( (errorCode == EAGAIN) || (errorCode == EWOULDBLOCK) || (errorCode == EINTR) || (errorCode == ECONNREFUSED) ) {
+            return returnValue;
+        }
+        throw std::runtime_error("CppSerialPort::UdpClient::readDatagrams(): recvmmsg(int, mmsghdr *, unsigned int, int, timespec *): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    for (size_t i = 0; i < receiveBatch.size(); i++) {
+        auto segmentSize = receiveBatch.segmentSize(i);
+        for (size_t offset = 0; offset < receiveBatch.length(i); offset += segmentSize) {
+            auto length = std::min(segmentSize, receiveBatch.length(i) - offset);
+            returnValue.emplace_back(receiveBatch.data(i) + offset, length);
+        }
+    }
+    return returnValue;
+}
+
+ssize_t UdpClient::write(char c)
+{
+    if (!this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::write(char): Cannot write on closed socket (call connect first)");
+    }
+    return this->write(&c, 1);
+}
+
+ssize_t UdpClient::write(const char *bytes, size_t numberOfBytes)
+{
+    if (!this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::write(const char *, size_t): Cannot write on closed socket (call connect first)");
+    }
+    //One write is one datagram, so a line written by writeLine() arrives as one message
+    auto sendResult = send(this->m_socketDescriptor, bytes, numberOfBytes, 0);
+    if (sendResult == -1) {
+        auto errorCode = errno;
+        throw std::runtime_error("CppSerialPort::UdpClient::write(const char *, size_t): send(int, const void *, int, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+    }
+    return sendResult;
+}
+
+size_t UdpClient::writeDatagrams(const std::vector<std::string> &datagrams)
+{
+    if (!this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::writeDatagrams(const std::vector<std::string> &): Cannot write on closed socket (call connect first)");
+    }
+    auto &sendBatch = *this->m_sendBatch;
+    size_t returnValue{0};
+    auto sendPending = [this, &sendBatch, &returnValue]() {
+        auto sendResult = sendBatch.send(this->m_socketDescriptor, 0);
+        if (sendResult == -1) {
+            auto errorCode = errno;
+            throw std::runtime_error("CppSerialPort::UdpClient::writeDatagrams(const std::vector<std::string> &): sendmmsg(int, mmsghdr *, unsigned int, int): error code " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ')');
+        }
+        returnValue += static_cast<size_t>(sendResult);
+    };
+    for (const auto &it : datagrams) {
+        iovec vector{const_cast<char *>(it.data()), it.length()};
+        if (!sendBatch.add(&vector, 1, nullptr, 0)) {
+            sendPending();
+            sendBatch.add(&vector, 1, nullptr, 0);
+        }
+    }
+    if (!sendBatch.empty()) {
+        sendPending();
+    }
+    return returnValue;
+}
+
+std::string UdpClient::portName() const
+{
+    return '[' + this->m_hostName + ':' + toStdString(this->m_portNumber) + ']';
+}
+
+bool UdpClient::isOpen() const
+{
+    return this->isConnected();
+}
+
+void UdpClient::openPort()
+{
+    if (!this->isConnected()) {
+        this->connect();
+    }
+}
+
+void UdpClient::closePort()
+{
+    if (this->isConnected()) {
+        this->disconnect();
+    }
+}
+
+void UdpClient::flushRx()
+{
+    this->m_readBuffer.clear();
+    this->m_readOffset = 0;
+}
+
+void UdpClient::flushTx()
+{
+
+}
+
+void UdpClient::putBack(char c)
+{
+    if (this->m_readOffset > 0) {
+        this->m_readBuffer[--this->m_readOffset] = c;
+    } else {
+        this->m_readBuffer.insert(this->m_readBuffer.begin(), c);
+    }
+}
+
+void UdpClient::setPortNumber(uint16_t portNumber)
+{
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::setPortNumber(uint16_t): Cannot set port number when already connected (call disconnect() first)");
+    }
+    this->m_portNumber = portNumber;
+}
+
+void UdpClient::setHostName(const std::string &hostName)
+{
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::setHostName(const std::string &): Cannot set host name when already connected (call disconnect() first)");
+    }
+    this->m_hostName = hostName;
+}
+
+uint16_t UdpClient::portNumber() const
+{
+    return this->m_portNumber;
+}
+
+std::string UdpClient::hostName() const
+{
+    return this->m_hostName;
+}
+
+void UdpClient::setBatchSize(size_t batchSize)
+{
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::setBatchSize(size_t): Cannot set batch size when already connected (call disconnect() first)");
+    }
+    if (batchSize == 0) {
+        throw std::runtime_error("CppSerialPort::UdpClient::setBatchSize(size_t): invariant failure (batch size cannot be 0)");
+    }
+    this->m_batchSize = batchSize;
+}
+
+size_t UdpClient::batchSize() const
+{
+    return this->m_batchSize;
+}
+
+void UdpClient::setOffloadEnabled(bool offloadEnabled)
+{
+    if (this->isConnected()) {
+        throw std::runtime_error("CppSerialPort::UdpClient::setOffloadEnabled(bool): Cannot change offload when already connected (call disconnect() first)");
+    }
+    this->m_offloadEnabled = offloadEnabled;
+}
+
+bool UdpClient::offloadEnabled() const
+{
+    return this->m_offloadEnabled;
+}
+
+} //namespace CppSerialPort
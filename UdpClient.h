@@ -0,0 +1,77 @@
+#ifndef CPPSERIALPORT_UDPCLIENT_H
+#define CPPSERIALPORT_UDPCLIENT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+#include "IByteStream.h"
+#include "DatagramBatch.h"
+
+namespace CppSerialPort {
+
+/*
+ * Connected UDP socket. write() sends one datagram, read() hands out the
+ * bytes of received datagrams one at a time. writeDatagrams() and
+ * readDatagrams() move many datagrams per sendmmsg()/recvmmsg() call
+ */
+class UdpClient : public IByteStream
+{
+public:
+    UdpClient(const std::string &hostName, uint16_t portNumber);
+    ~UdpClient() override;
+
+    using IByteStream::read;
+    char read() override;
+    ssize_t write(char c) override;
+    ssize_t write(const char *bytes, size_t numberOfBytes) override;
+    std::string portName() const override;
+    bool isOpen() const override;
+    void openPort() override;
+    void closePort() override;
+    void flushRx() override;
+    void flushTx() override;
+    void putBack(char c) override;
+
+    size_t writeDatagrams(const std::vector<std::string> &datagrams);
+    std::vector<std::string> readDatagrams();
+
+    void connect(const std::string &hostName, uint16_t portNumber);
+    void connect();
+    bool disconnect();
+    bool isConnected() const;
+    void setPortNumber(uint16_t portNumber);
+    void setHostName(const std::string &hostName);
+    uint16_t portNumber() const;
+    std::string hostName() const;
+    void setBatchSize(size_t batchSize);
+    size_t batchSize() const;
+    void setOffloadEnabled(bool offloadEnabled);
+    bool offloadEnabled() const;
+
+    static const size_t DEFAULT_BATCH_SIZE;
+
+private:
+    int m_socketDescriptor;
+    uint16_t m_portNumber;
+    std::string m_hostName;
+    std::string m_readBuffer;
+    size_t m_readOffset;
+    size_t m_batchSize;
+    bool m_offloadEnabled;
+    std::unique_ptr<DatagramReceiveBatch> m_receiveBatch;
+    std::unique_ptr<DatagramSendBatch> m_sendBatch;
+
+    bool waitForReadable(int timeout);
+    void createBatches();
+    static std::string getErrorString(int errorCode);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_UDPCLIENT_H
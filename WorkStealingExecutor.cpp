@@ -0,0 +1,135 @@
+#include "WorkStealingExecutor.h"
+
+#include <stdexcept>
+
+namespace CppSerialPort {
+
+static thread_local WorkStealingExecutor *currentExecutor{nullptr};
+static thread_local size_t currentWorkerIndex{0};
+
+WorkStealingExecutor::WorkStealingExecutor(size_t workerCount) :
+    m_workers{},
+    m_threads{},
+    m_nextWorker{0},
+    m_queuedTasks{0},
+    m_idleWorkers{0},
+    m_stopping{false},
+    m_idleMutex{},
+    m_idleCondition{}
+{
+    if (workerCount == 0) {
+        throw std::runtime_error("CppSerialPort::WorkStealingExecutor::WorkStealingExecutor(size_t): invariant failure (worker count must be positive)");
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        this->m_workers.emplace_back(new Worker{});
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        this->m_threads.emplace_back([this, i]() { this->runWorker(i); });
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    this->stop();
+}
+
+void WorkStealingExecutor::submit(std::function<void()> task)
+{
+    auto index = ( (currentExecutor == this) ? currentWorkerIndex : (this->m_nextWorker++ % this->m_workers.size()) );
+    //Counted before it is visible, so a worker that takes it never sees the count go below zero
+    this->m_queuedTasks++;
+    {
+        auto &worker = *this->m_workers[index];
+        std::lock_guard<std::mutex> workerLock{worker.mutex};
+        (void)workerLock;
+        worker.tasks.push_back(std::move(task));
+    }
+    //Paired with the idle count going up before a worker checks for tasks, so one of the two always sees the other
+    if (this->m_idleWorkers > 0) {
+        {
+            std::lock_guard<std::mutex> idleLock{this->m_idleMutex};
+            (void)idleLock;
+        }
+        this->m_idleCondition.notify_one();
+    }
+}
+
+void WorkStealingExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> idleLock{this->m_idleMutex};
+        (void)idleLock;
+        this->m_stopping = true;
+    }
+    this->m_idleCondition.notify_all();
+    for (auto &it : this->m_threads) {
+        if (it.joinable()) {
+            it.join();
+        }
+    }
+}
+
+size_t WorkStealingExecutor::workerCount() const
+{
+    return this->m_workers.size();
+}
+
+bool WorkStealingExecutor::isWorkerThread()
+{
+    return (currentExecutor != nullptr);
+}
+
+bool WorkStealingExecutor::takeTask(size_t index, std::function<void()> &task)
+{
+    //Own deque first, oldest task first
+    {
+        auto &worker = *this->m_workers[index];
+        std::lock_guard<std::mutex> workerLock{worker.mutex};
+        (void)workerLock;
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            return true;
+        }
+    }
+    //Steal from the opposite end, away from where the owner is working
+    for (size_t i = 1; i < this->m_workers.size(); i++) {
+        auto &victim = *this->m_workers[(index + i) % this->m_workers.size()];
+        std::lock_guard<std::mutex> victimLock{victim.mutex};
+        (void)victimLock;
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::runWorker(size_t index)
+{
+    currentExecutor = this;
+    currentWorkerIndex = index;
+    std::function<void()> task{};
+    while (true) {
+        if (this->takeTask(index, task)) {
+            this->m_queuedTasks--;
+            task();
+            task = nullptr;
+            continue;
+        }
+        this->m_idleWorkers++;
+        {
+            std::unique_lock<std::mutex> idleLock{this->m_idleMutex};
+            this->m_idleCondition.wait(idleLock, [this]() { return ( (this->m_queuedTasks > 0) || (this->m_stopping) ); });
+        }
+        this->m_idleWorkers--;
+        //Stopping only ends the worker once everything queued has run
+        if ( (this->m_stopping) && (this->m_queuedTasks == 0) ) {
+            break;
+        }
+    }
+    currentExecutor = nullptr;
+}
+
+} //namespace CppSerialPort
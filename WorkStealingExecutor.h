@@ -0,0 +1,64 @@
+#ifndef CPPSERIALPORT_WORKSTEALINGEXECUTOR_H
+#define CPPSERIALPORT_WORKSTEALINGEXECUTOR_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+/*
+ * Fixed pool of worker threads, each with its own task deque. A worker takes
+ * tasks from the front of its own deque and, once that is empty, steals from
+ * the back of the others before going to sleep, so one slow task never holds
+ * up the tasks queued behind it while another worker is idle. Tasks submitted
+ * from a worker go to that worker's deque, everything else is spread round
+ * robin. There is no ordering between tasks, callers that need it serialize
+ * their own tasks (see TcpServer)
+ */
+class WorkStealingExecutor
+{
+public:
+    explicit WorkStealingExecutor(size_t workerCount);
+    ~WorkStealingExecutor();
+    WorkStealingExecutor(const WorkStealingExecutor &) = delete;
+    WorkStealingExecutor &operator=(const WorkStealingExecutor &) = delete;
+
+    void submit(std::function<void()> task);
+    //Runs every task already queued, including any those tasks submit, then joins the workers
+    void stop();
+    size_t workerCount() const;
+
+    //True on any executor's worker thread
+    static bool isWorkerThread();
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_nextWorker;
+    //Queued, not yet started, tasks across every deque
+    std::atomic<size_t> m_queuedTasks;
+    std::atomic<size_t> m_idleWorkers;
+    std::atomic<bool> m_stopping;
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCondition;
+
+    void runWorker(size_t index);
+    bool takeTask(size_t index, std::function<void()> &task);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_WORKSTEALINGEXECUTOR_H
@@ -0,0 +1,69 @@
+#include "ZeroCopy.h"
+
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+
+#if !defined(SO_ZEROCOPY)
+#    define SO_ZEROCOPY 60
+#endif //!defined(SO_ZEROCOPY)
+#if !defined(MSG_ZEROCOPY)
+#    define MSG_ZEROCOPY 0x4000000
+#endif //!defined(MSG_ZEROCOPY)
+#if !defined(SO_EE_ORIGIN_ZEROCOPY)
+#    define SO_EE_ORIGIN_ZEROCOPY 5
+#endif //!defined(SO_EE_ORIGIN_ZEROCOPY)
+#if !defined(SO_EE_CODE_ZEROCOPY_COPIED)
+#    define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif //!defined(SO_EE_CODE_ZEROCOPY_COPIED)
+
+namespace CppSerialPort {
+
+const int ZeroCopy::SEND_FLAG{MSG_ZEROCOPY};
+const size_t ZeroCopy::DEFAULT_THRESHOLD{32 * 1024};
+
+bool ZeroCopy::enable(int socketDescriptor)
+{
+    int enabled{1};
+    return (setsockopt(socketDescriptor, SOL_SOCKET, SO_ZEROCOPY, &enabled, sizeof(enabled)) != -1);
+}
+
+bool ZeroCopy::readCompletions(int socketDescriptor, std::vector<Completion> &completions)
+{
+    while (true) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err)) + CMSG_SPACE(sizeof(sockaddr_in6))];
+        msghdr message{};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        if (recvmsg(socketDescriptor, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) {
+                return true;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        for (auto header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            auto ipError = ( (header->cmsg_level == SOL_IP) && (header->cmsg_type == IP_RECVERR) );
+            auto ipv6Error = ( (header->cmsg_level == SOL_IPV6) && (header->cmsg_type == IPV6_RECVERR) );
+            if ( (!ipError) && (!ipv6Error) ) {
+                continue;
+            }
+            auto error = reinterpret_cast<const sock_extended_err *>(CMSG_DATA(header));
+            //Anything else on the error queue is a real error, which SO_ERROR reports as well
+            if ( (error->ee_errno != 0) || (error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) ) {
+                continue;
+            }
+            completions.push_back(Completion{error->ee_info, error->ee_data, ((error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0)});
+        }
+    }
+}
+
+bool ZeroCopy::covers(const Completion &completion, uint32_t sequence)
+{
+    return (static_cast<uint32_t>(sequence - completion.first) <= static_cast<uint32_t>(completion.last - completion.first));
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,44 @@
+#ifndef CPPSERIALPORT_ZEROCOPY_H
+#define CPPSERIALPORT_ZEROCOPY_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace CppSerialPort {
+
+/*
+ * MSG_ZEROCOPY plumbing shared by TcpServer and TcpClient. A zero copy send
+ * pins the caller's pages instead of copying them into the socket buffer, so
+ * the bytes must stay untouched until the kernel reports the send complete on
+ * the socket's error queue. Every successful zero copy send on a socket gets
+ * the next 32 bit sequence number, starting at 0, and completions arrive as
+ * ranges of those numbers. Below a few KB the page pinning and the extra
+ * notification cost more than the copy they save
+ */
+class ZeroCopy
+{
+public:
+    struct Completion
+    {
+        uint32_t first;
+        uint32_t last;
+        //The kernel copied the data after all (loopback, or a device without scatter-gather)
+        bool copied;
+    };
+
+    //Sets SO_ZEROCOPY, returns false (errno set) if the kernel does not support it
+    static bool enable(int socketDescriptor);
+    //Reads every notification queued on the socket's error queue without blocking.
+    //Returns false (errno set) if the error queue could not be read
+    static bool readCompletions(int socketDescriptor, std::vector<Completion> &completions);
+    //Whether sequence falls in completion, allowing for the sequence numbers wrapping
+    static bool covers(const Completion &completion, uint32_t sequence);
+
+    static const int SEND_FLAG;
+    static const size_t DEFAULT_THRESHOLD;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_ZEROCOPY_H